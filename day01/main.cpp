@@ -1,8 +1,14 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstdint>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <numeric>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace {
@@ -11,23 +17,256 @@ namespace {
         SECOND
     };
 
-    void addNewTotal(std::vector<std::size_t>& max_calories, std::size_t new_total) {
-        // if current total higher than lowest kept total, replace
-        if (max_calories[0] < new_total) {
+    struct ElfTotal {
+        std::size_t calories = 0;
+        std::size_t elf = 0; // elf number, starting at 1
 
-            max_calories[0]  = new_total;
+        bool operator<(const ElfTotal& other) const { return calories < other.calories; }
+        bool operator>(const ElfTotal& other) const { return other < *this; }
+    };
+
+    // Keeps the K highest totals, for small K known at compile time
+    template <std::size_t K>
+    class TopCalories {
+        public:
+            void add(const ElfTotal& new_total) {
+                // if current total higher than lowest kept total, replace
+                if (max_calories_[0] < new_total) {
+
+                    max_calories_[0] = new_total;
+
+                    // reorder so that highest is last
+                    for (std::size_t idx = 0; idx < K - 1; ++idx) {
+                        if (max_calories_[idx + 1] < max_calories_[idx]) {
+                            std::swap(max_calories_[idx+1], max_calories_[idx]);
+                        } else {
+                            return;
+                        }
+                    }
+                }
+            }
+
+            // highest total first, empty slots are skipped
+            std::vector<ElfTotal> sorted() const {
+                std::vector<ElfTotal> totals;
+                for (auto it = max_calories_.crbegin(); it != max_calories_.crend(); ++it) {
+                    if (it->elf != 0) totals.push_back(*it);
+                }
+                return totals;
+            }
+
+        private:
+            std::array<ElfTotal, K> max_calories_ = {};
+    };
+
+    // Keeps the k highest totals in a min-heap, for large k known at runtime
+    class TopCaloriesHeap {
+        public:
+            TopCaloriesHeap(std::size_t k) : k_{k} { heap_.reserve(k); }
 
-            // reorder so that highest is last
-            std::size_t max_idx = max_calories.size()-1;
-            for (std::size_t idx = 0; idx < max_idx; ++idx) {
-                if (max_calories[idx + 1] < max_calories[idx]) {
-                    std::swap(max_calories[idx+1], max_calories[idx]);
-                } else {
-                    return;
+            void add(const ElfTotal& new_total) {
+                if (heap_.size() < k_) {
+                    heap_.push_back(new_total);
+                    std::push_heap(heap_.begin(), heap_.end(), std::greater<>{});
+                } else if (k_ > 0 && heap_.front() < new_total) {
+                    // replace lowest kept total
+                    std::pop_heap(heap_.begin(), heap_.end(), std::greater<>{});
+                    heap_.back() = new_total;
+                    std::push_heap(heap_.begin(), heap_.end(), std::greater<>{});
                 }
             }
+
+            // highest total first
+            std::vector<ElfTotal> sorted() const {
+                std::vector<ElfTotal> totals = heap_;
+                std::sort(totals.begin(), totals.end(), std::greater<>{});
+                return totals;
+            }
+
+        private:
+            std::size_t k_;
+            std::vector<ElfTotal> heap_;
+    };
+
+    // running state while reading elves line by line
+    struct ElfCounter {
+        std::size_t current_calories = 0;
+        std::size_t num_elves = 0;
+
+        // returns true if the line completed an elf
+        template <typename TopCaloriesT>
+        bool addLine(const std::string& line, TopCaloriesT& top_calories) {
+            if (line.empty()) { // new elf
+                top_calories.add({current_calories, ++num_elves});
+                current_calories = 0;
+                return true;
+            } else {
+                current_calories += std::stoi(line);
+                return false;
+            }
+        }
+
+        // if last line is not empty
+        template <typename TopCaloriesT>
+        void finish(TopCaloriesT& top_calories) {
+            if (current_calories > 0) {
+                top_calories.add({current_calories, ++num_elves});
+                current_calories = 0;
+            }
+        }
+    };
+
+    // read elves from the stream until max_bytes have been consumed (or eof),
+    // keeping the highest totals in top_calories. Returns the number of elves read.
+    template <typename TopCaloriesT>
+    std::size_t addTotals(std::istream& istream, std::size_t max_bytes, TopCaloriesT& top_calories) {
+        ElfCounter counter;
+        std::size_t consumed_bytes = 0;
+        std::string line;
+        while (consumed_bytes < max_bytes && std::getline(istream, line)) {
+            consumed_bytes += line.size() + 1;
+            counter.addLine(line, top_calories);
+        }
+        counter.finish(top_calories);
+
+        return counter.num_elves;
+    }
+
+    template <typename TopCaloriesT>
+    void printTop(const TopCaloriesT& top_calories) {
+        std::size_t sum = 0;
+        std::cout << "top:";
+        for (const ElfTotal& total : top_calories.sorted()) {
+            std::cout << " " << total.calories << " (elf " << total.elf << ")";
+            sum += total.calories;
+        }
+        std::cout << " | sum: " << sum << std::endl;
+    }
+
+    // Keep reading the file as it grows, polling for appended lines. The top calories
+    // are printed whenever an elf is completed, once the existing content was read.
+    // Never returns.
+    template <typename TopCaloriesT>
+    void follow(std::ifstream& ifile, std::chrono::milliseconds poll_interval, TopCaloriesT& top_calories) {
+        ElfCounter counter;
+        bool caught_up = false;
+        std::string partial_line; // line which has not been terminated yet
+        std::string line;
+        while (true) {
+            if (!std::getline(ifile, line) || ifile.eof()) {
+                // reached current end of file, wait for more data
+                partial_line += line;
+                ifile.clear();
+                if (!caught_up) {
+                    caught_up = true;
+                    std::cout << counter.num_elves << " elves, ";
+                    printTop(top_calories);
+                }
+                std::this_thread::sleep_for(poll_interval);
+                continue;
+            }
+
+            partial_line += line;
+            if (counter.addLine(partial_line, top_calories) && caught_up) {
+                std::cout << "Elf " << counter.num_elves << " done, ";
+                printTop(top_calories);
+            }
+            partial_line.clear();
+        }
+    }
+
+    // Find start of the first elf at or after offset, i.e. the first position after an empty line.
+    // Returns file_size if there is no further elf.
+    std::size_t findElfStart(const std::string& filename, std::size_t offset, std::size_t file_size) {
+        if (offset == 0) {
+            return 0;
+        }
+
+        std::ifstream ifile(filename, std::ios::binary);
+        ifile.seekg(offset - 1);
+
+        // an elf starts after "\n\n", previous char might already be the first '\n'
+        char previous = 0;
+        char c;
+        std::size_t pos = offset - 1;
+        while (ifile.get(c)) {
+            ++pos;
+            if (c == '\n' && previous == '\n') {
+                return pos;
+            }
+            previous = c;
+        }
+
+        return file_size;
+    }
+
+    // Split file in num_chunks chunks aligned to elf boundaries, compute the top calories of
+    // each chunk in its own thread and merge the partial results into top_calories
+    template <typename TopCaloriesT>
+    void parallelTopCalories(const std::string& filename, std::size_t num_chunks, TopCaloriesT& top_calories) {
+        std::ifstream ifile(filename, std::ios::binary | std::ios::ate);
+        const std::size_t file_size = ifile.tellg();
+
+        std::vector<std::size_t> chunk_starts(num_chunks + 1, file_size);
+        for (std::size_t i = 0; i < num_chunks; ++i) {
+            chunk_starts[i] = findElfStart(filename, i * (file_size / num_chunks), file_size);
+        }
+
+        std::vector<TopCaloriesT> partial_top(num_chunks, top_calories);
+        std::vector<std::size_t> chunk_elves(num_chunks, 0);
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < num_chunks; ++i) {
+            // chunks may be empty if an elf spans multiple nominal chunks
+            if (chunk_starts[i] >= chunk_starts[i + 1]) {
+                continue;
+            }
+
+            workers.emplace_back([&, i]() {
+                std::ifstream chunk_file(filename, std::ios::binary);
+                chunk_file.seekg(chunk_starts[i]);
+                chunk_elves[i] = addTotals(chunk_file, chunk_starts[i + 1] - chunk_starts[i], partial_top[i]);
+            });
+        }
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        // merge partial results by inserting them like any other elf total,
+        // elf numbers are shifted by the number of elves in the preceding chunks
+        std::size_t elf_offset = 0;
+        for (std::size_t i = 0; i < num_chunks; ++i) {
+            for (ElfTotal total : partial_top[i].sorted()) {
+                total.elf += elf_offset;
+                top_calories.add(total);
+            }
+            elf_offset += chunk_elves[i];
         }
     }
+
+    template <typename TopCaloriesT>
+    void solve(std::ifstream& ifile, const std::string& filename, std::size_t num_threads,
+               TopCaloriesT top_calories, bool print_elves, std::size_t poll_interval_ms) {
+        if (poll_interval_ms > 0) {
+            follow(ifile, std::chrono::milliseconds(poll_interval_ms), top_calories);
+        } else if (num_threads > 1) {
+            parallelTopCalories(filename, num_threads, top_calories);
+        } else {
+            addTotals(ifile, std::numeric_limits<std::size_t>::max(), top_calories);
+        }
+
+        const std::vector<ElfTotal> totals = top_calories.sorted();
+        if (print_elves) {
+            for (const ElfTotal& total : totals) {
+                std::cout << "Elf " << total.elf << ": " << total.calories << std::endl;
+            }
+        }
+
+        std::cout << "Sum of top calories: "
+                  << std::accumulate(totals.cbegin(), totals.cend(), std::size_t{0},
+                                     [](std::size_t sum, const ElfTotal& total) { return sum + total.calories; })
+                  << std::endl;
+    }
 }
 
 
@@ -51,6 +290,29 @@ int main(int argc, char** argv) {
         }
     }
 
+    // optional: number of threads, 0 for one per hardware thread
+    std::size_t num_threads = 1;
+    if (argc > 3) {
+        num_threads = std::atol(argv[3]);
+        if (num_threads == 0) {
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+    }
+
+    // optional: number of top elves to keep (overrides part), these are listed individually
+    bool print_elves = false;
+    if (argc > 4) {
+        num_max = std::atol(argv[4]);
+        print_elves = true;
+    }
+
+    // optional: follow mode, keep polling the file for new elves with the given interval [ms]
+    // Note: always reads with a single thread
+    std::size_t poll_interval_ms = 0;
+    if (argc > 5) {
+        poll_interval_ms = std::atol(argv[5]);
+    }
+
     std::string filename = argv[1];
     std::ifstream ifile(argv[1]);
 
@@ -59,24 +321,17 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    std::vector<std::size_t> max_calories(num_max, 0);
-    std::size_t current_calories = 0;
-    std::string line;
-    while (std::getline(ifile, line)) {
-        if (line.empty()) { // new elf
-            addNewTotal(max_calories, current_calories);
-            current_calories = 0;
-        } else {
-            current_calories += std::stoi(line);
-        }
+    switch (num_max) {
+        case 1:
+            solve(ifile, filename, num_threads, TopCalories<1>{}, print_elves, poll_interval_ms);
+            break;
+        case 3:
+            solve(ifile, filename, num_threads, TopCalories<3>{}, print_elves, poll_interval_ms);
+            break;
+        default:
+            solve(ifile, filename, num_threads, TopCaloriesHeap{num_max}, print_elves, poll_interval_ms);
+            break;
     }
 
-    // if last line is not empty
-    if (current_calories > 0) {
-        addNewTotal(max_calories, current_calories);
-    }
-
-    std::cout << "Sum of top calories: " << std::accumulate(max_calories.cbegin(), max_calories.cend(), std::size_t{0}) << std::endl;
-
     return 0;
-}
\ No newline at end of file
+}
@@ -1,20 +1,87 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <numeric>
 #include <string>
 #include <vector>
 
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
 namespace {
     enum class Part {
         FIRST = 0,
         SECOND
     };
+
+    enum class Method {
+        STREAM = 0, // parse one round at a time from the file stream
+        BUFFER,     // read whole file, score fixed-width rounds through lookup table
+        HISTOGRAM,  // count each of the possible rounds once, score all rules from the counts
+        PACK,       // convert text input to packed binary file <input>.packed
+        PACKED      // score packed binary input
+    };
+
+    // Description of a game variant: playing hand i scores hand_scores[i] and hand i
+    // wins against hand j if beats[i][j]. Opponent hands are labelled from first_opponent,
+    // own hands (part 1) and the outcomes lose, draw, win (part 2) from first_player.
+    template <std::size_t NUM_HANDS>
+    struct Rules {
+        std::array<unsigned int, NUM_HANDS> hand_scores = {};
+        std::array<std::array<bool, NUM_HANDS>, NUM_HANDS> beats = {};
+        unsigned int lose_score = 0;
+        unsigned int draw_score = 3;
+        unsigned int win_score = 6;
+        char first_opponent = 'A';
+        char first_player = 'X';
+
+        // index of a round in score tables and histograms, out of range for invalid input
+        constexpr std::size_t index(char c1, char c2) const {
+            return static_cast<std::size_t>(c1 - first_opponent) * NUM_HANDS + static_cast<std::size_t>(c2 - first_player);
+        }
+    };
+
+    // Each hand beats the (NUM_HANDS - 1) / 2 hands preceding it (wrapped around) and scores
+    // its position + 1, e.g. rock, paper, scissors or rock, spock, paper, lizard, scissors
+    template <std::size_t NUM_HANDS>
+    constexpr Rules<NUM_HANDS> makeCyclicRules(char first_opponent, char first_player) {
+        static_assert(NUM_HANDS % 2 == 1, "Cyclic rules need an odd number of hands");
+
+        Rules<NUM_HANDS> rules;
+        rules.first_opponent = first_opponent;
+        rules.first_player = first_player;
+        for (std::size_t hand = 0; hand < NUM_HANDS; ++hand) {
+            rules.hand_scores[hand] = hand + 1;
+            for (std::size_t shift = 1; shift <= (NUM_HANDS - 1) / 2; ++shift) {
+                rules.beats[hand][(hand + NUM_HANDS - shift) % NUM_HANDS] = true;
+            }
+        }
+        return rules;
+    }
+
+    constexpr Rules<3> ROCK_PAPER_SCISSORS = makeCyclicRules<3>('A', 'X');
+
+    // player hands are V-Z, part 2 uses V, W, X for lose, draw, win
+    constexpr Rules<5> ROCK_PAPER_SCISSORS_LIZARD_SPOCK = makeCyclicRules<5>('A', 'V');
+
+    // score of each round, indexed by Rules::index
+    // padded to at least 16 entries so that small tables fit into one SIMD register
+    template <std::size_t NUM_HANDS>
+    using ScoreTable = std::array<std::uint8_t, std::max<std::size_t>(16, NUM_HANDS * NUM_HANDS)>;
+
+    // number of occurrences of each round, same indexing as ScoreTable
+    template <std::size_t NUM_HANDS>
+    using RoundHistogram = std::array<std::size_t, NUM_HANDS * NUM_HANDS>;
 }
 
-unsigned int getScorePart1(char c1, char c2) {
-    static constexpr unsigned int WIN_SCORE = 6;
-    static constexpr unsigned int DRAW_SCORE = 3;
+constexpr unsigned int getScorePart1(char c1, char c2) {
+    constexpr unsigned int WIN_SCORE = 6;
+    constexpr unsigned int DRAW_SCORE = 3;
 
     // map X,Y,Z also to A,B,C
     c2 = c2 - ('X' - 'A');
@@ -37,8 +104,8 @@ unsigned int getScorePart1(char c1, char c2) {
     return selection_score;
 }
 
-unsigned int getScorePart2(char c1, char c2) {
-    static constexpr unsigned int SCORE = 3;
+constexpr unsigned int getScorePart2(char c1, char c2) {
+    constexpr unsigned int SCORE = 3;
 
     // X : lose, Y : draw, Z : win
     //
@@ -57,6 +124,464 @@ unsigned int getScorePart2(char c1, char c2) {
     return (1 + (c1 + c2 + 2) % 3) + (c2 - 'X') * SCORE; 
 }
 
+template <std::size_t NUM_HANDS>
+constexpr unsigned int getOutcomeScore(const Rules<NUM_HANDS>& rules, std::size_t opponent, std::size_t own) {
+    if (rules.beats[own][opponent]) {
+        return rules.win_score;
+    } else if (rules.beats[opponent][own]) {
+        return rules.lose_score;
+    }
+    return rules.draw_score;
+}
+
+// part 1 : second column is our hand
+template <std::size_t NUM_HANDS>
+constexpr ScoreTable<NUM_HANDS> makeScoreTablePart1(const Rules<NUM_HANDS>& rules) {
+    ScoreTable<NUM_HANDS> table = {};
+    for (std::size_t opponent = 0; opponent < NUM_HANDS; ++opponent) {
+        for (std::size_t own = 0; own < NUM_HANDS; ++own) {
+            table[opponent * NUM_HANDS + own] = rules.hand_scores[own] + getOutcomeScore(rules, opponent, own);
+        }
+    }
+    return table;
+}
+
+// part 2 : second column is the desired outcome (lose, draw, win),
+// if several hands achieve it, the first one is played
+template <std::size_t NUM_HANDS>
+constexpr ScoreTable<NUM_HANDS> makeScoreTablePart2(const Rules<NUM_HANDS>& rules) {
+    const std::array<unsigned int, 3> outcome_scores = {rules.lose_score, rules.draw_score, rules.win_score};
+
+    ScoreTable<NUM_HANDS> table = {};
+    for (std::size_t opponent = 0; opponent < NUM_HANDS; ++opponent) {
+        for (std::size_t outcome = 0; outcome < outcome_scores.size(); ++outcome) {
+            for (std::size_t own = 0; own < NUM_HANDS; ++own) {
+                if (getOutcomeScore(rules, opponent, own) == outcome_scores[outcome]) {
+                    table[opponent * NUM_HANDS + outcome] = rules.hand_scores[own] + outcome_scores[outcome];
+                    break;
+                }
+            }
+        }
+    }
+    return table;
+}
+
+// Score table of part 1 if own hand i is actually labelled mapping[i]
+template <std::size_t NUM_HANDS>
+constexpr ScoreTable<NUM_HANDS> permuteOwnHands(const ScoreTable<NUM_HANDS>& table,
+                                                const std::array<std::size_t, NUM_HANDS>& mapping) {
+    ScoreTable<NUM_HANDS> permuted = {};
+    for (std::size_t opponent = 0; opponent < NUM_HANDS; ++opponent) {
+        for (std::size_t own = 0; own < NUM_HANDS; ++own) {
+            permuted[opponent * NUM_HANDS + own] = table[opponent * NUM_HANDS + mapping[own]];
+        }
+    }
+    return permuted;
+}
+
+// reference tables from the hand-derived arithmetic above
+template <typename ScoreFunction>
+constexpr ScoreTable<3> makeScoreTable(ScoreFunction get_score) {
+    ScoreTable<3> table = {};
+    for (char c1 = 'A'; c1 <= 'C'; ++c1) {
+        for (char c2 = 'X'; c2 <= 'Z'; ++c2) {
+            table[ROCK_PAPER_SCISSORS.index(c1, c2)] = get_score(c1, c2);
+        }
+    }
+    return table;
+}
+
+static_assert(makeScoreTablePart1(ROCK_PAPER_SCISSORS) == makeScoreTable(getScorePart1));
+static_assert(makeScoreTablePart2(ROCK_PAPER_SCISSORS) == makeScoreTable(getScorePart2));
+
+// Score a buffer of fixed-width "A X\n" rounds (the last eol is optional).
+// Returns false if the buffer does not have the expected layout.
+template <std::size_t NUM_HANDS>
+bool scoreBuffer(const char* data, std::size_t size, const Rules<NUM_HANDS>& rules,
+                 const ScoreTable<NUM_HANDS>& table, std::size_t& total_score) {
+    std::size_t pos = 0;
+    total_score = 0;
+
+#if defined(__SSSE3__)
+    // whole table needs to fit into one register for the byte shuffle lookup
+    if constexpr (NUM_HANDS * NUM_HANDS <= 16) {
+        // Each 32 bit lane holds one round: c1 in byte 0, c2 in byte 2.
+        // Hands outside of the rules make the layout invalid, checked by an unsigned byte
+        // max of the hands relative to the first hand against the last valid hand.
+        // The table index is computed per lane (c1 * NUM_HANDS through a multiply-add of
+        // 16 bit halves), the upper bytes of the index are set to 0x80 so that the byte
+        // shuffle zeroes them. Scores are summed up into 64 bit lanes with sad against zero.
+        const char format_bytes[4] = {0, ' ', 0, '\n'};
+        std::int32_t format;
+        std::copy(std::begin(format_bytes), std::end(format_bytes), reinterpret_cast<char*>(&format));
+        const std::int32_t offset = rules.first_opponent * NUM_HANDS + rules.first_player;
+        const std::int32_t first_hands = static_cast<unsigned char>(rules.first_opponent) |
+                                         (static_cast<unsigned char>(rules.first_player) << 16);
+        const std::int32_t last_hands = (NUM_HANDS - 1) | ((NUM_HANDS - 1) << 16);
+
+#if defined(__AVX2__)
+        // 32 rounds per iteration
+        static constexpr std::size_t BLOCK_SIZE = 32;
+        static constexpr std::size_t STEP = 4 * BLOCK_SIZE;
+
+        const __m256i table_v = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table.data())));
+        const __m256i byte_mask_v = _mm256_set1_epi32(0xFF);
+        const __m256i format_mask_v = _mm256_set1_epi32(0xFF00FF00);
+        const __m256i format_v = _mm256_set1_epi32(format);
+        const __m256i hand_mask_v = _mm256_set1_epi32(0x00FF00FF);
+        const __m256i first_hands_v = _mm256_set1_epi32(first_hands);
+        const __m256i last_hands_v = _mm256_set1_epi32(last_hands);
+        const __m256i hands_v = _mm256_set1_epi32(NUM_HANDS);
+        const __m256i offset_v = _mm256_set1_epi32(offset);
+        const __m256i zero_upper_v = _mm256_set1_epi32(0xFFFFFF00);
+        const __m256i zero_v = _mm256_setzero_si256();
+
+        __m256i sum_v = zero_v;
+        __m256i invalid_v = zero_v;
+
+        auto score_block = [&](const char* block) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+            invalid_v = _mm256_or_si256(invalid_v, _mm256_xor_si256(_mm256_and_si256(v, format_mask_v), format_v));
+            const __m256i hands = _mm256_sub_epi8(v, first_hands_v);
+            const __m256i clamped = _mm256_max_epu8(hands, last_hands_v);
+            invalid_v = _mm256_or_si256(invalid_v, _mm256_and_si256(_mm256_xor_si256(clamped, last_hands_v), hand_mask_v));
+
+            const __m256i c1 = _mm256_and_si256(v, byte_mask_v);
+            const __m256i c2 = _mm256_and_si256(_mm256_srli_epi32(v, 16), byte_mask_v);
+            __m256i idx = _mm256_add_epi32(_mm256_madd_epi16(c1, hands_v), c2);
+            idx = _mm256_or_si256(_mm256_sub_epi32(idx, offset_v), zero_upper_v);
+
+            sum_v = _mm256_add_epi64(sum_v, _mm256_sad_epu8(_mm256_shuffle_epi8(table_v, idx), zero_v));
+        };
+
+        for (; pos + STEP <= size; pos += STEP) {
+            score_block(data + pos);
+            score_block(data + pos + BLOCK_SIZE);
+            score_block(data + pos + 2 * BLOCK_SIZE);
+            score_block(data + pos + 3 * BLOCK_SIZE);
+        }
+
+        if (!_mm256_testz_si256(invalid_v, invalid_v)) {
+            return false;
+        }
+
+        std::array<std::uint64_t, 4> sums;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums.data()), sum_v);
+#else
+        // 16 rounds per iteration
+        static constexpr std::size_t BLOCK_SIZE = 16;
+        static constexpr std::size_t STEP = 4 * BLOCK_SIZE;
+
+        const __m128i table_v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.data()));
+        const __m128i byte_mask_v = _mm_set1_epi32(0xFF);
+        const __m128i format_mask_v = _mm_set1_epi32(0xFF00FF00);
+        const __m128i format_v = _mm_set1_epi32(format);
+        const __m128i hand_mask_v = _mm_set1_epi32(0x00FF00FF);
+        const __m128i first_hands_v = _mm_set1_epi32(first_hands);
+        const __m128i last_hands_v = _mm_set1_epi32(last_hands);
+        const __m128i hands_v = _mm_set1_epi32(NUM_HANDS);
+        const __m128i offset_v = _mm_set1_epi32(offset);
+        const __m128i zero_upper_v = _mm_set1_epi32(0xFFFFFF00);
+        const __m128i zero_v = _mm_setzero_si128();
+
+        __m128i sum_v = zero_v;
+        __m128i invalid_v = zero_v;
+
+        auto score_block = [&](const char* block) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+            invalid_v = _mm_or_si128(invalid_v, _mm_xor_si128(_mm_and_si128(v, format_mask_v), format_v));
+            const __m128i hands = _mm_sub_epi8(v, first_hands_v);
+            const __m128i clamped = _mm_max_epu8(hands, last_hands_v);
+            invalid_v = _mm_or_si128(invalid_v, _mm_and_si128(_mm_xor_si128(clamped, last_hands_v), hand_mask_v));
+
+            const __m128i c1 = _mm_and_si128(v, byte_mask_v);
+            const __m128i c2 = _mm_and_si128(_mm_srli_epi32(v, 16), byte_mask_v);
+            __m128i idx = _mm_add_epi32(_mm_madd_epi16(c1, hands_v), c2);
+            idx = _mm_or_si128(_mm_sub_epi32(idx, offset_v), zero_upper_v);
+
+            sum_v = _mm_add_epi64(sum_v, _mm_sad_epu8(_mm_shuffle_epi8(table_v, idx), zero_v));
+        };
+
+        for (; pos + STEP <= size; pos += STEP) {
+            score_block(data + pos);
+            score_block(data + pos + BLOCK_SIZE);
+            score_block(data + pos + 2 * BLOCK_SIZE);
+            score_block(data + pos + 3 * BLOCK_SIZE);
+        }
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid_v, zero_v)) != 0xFFFF) {
+            return false;
+        }
+
+        std::array<std::uint64_t, 2> sums;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums.data()), sum_v);
+#endif
+        total_score = std::accumulate(sums.cbegin(), sums.cend(), std::uint64_t{0});
+    }
+#endif
+
+    // scalar tail (or everything if no SIMD support)
+    for (; pos + 3 <= size; pos += 4) {
+        if (data[pos + 1] != ' ' || (pos + 3 < size && data[pos + 3] != '\n')) {
+            return false;
+        }
+        if (static_cast<unsigned char>(data[pos] - rules.first_opponent) >= NUM_HANDS ||
+            static_cast<unsigned char>(data[pos + 2] - rules.first_player) >= NUM_HANDS) {
+            return false;
+        }
+        total_score += table[rules.index(data[pos], data[pos + 2])];
+    }
+
+    // allow for trailing eol
+    return (pos >= size || data[pos] == '\n');
+}
+
+std::vector<char> readFile(std::ifstream& ifile) {
+    ifile.seekg(0, std::ios::end);
+    std::vector<char> buffer(ifile.tellg());
+    ifile.seekg(0);
+    ifile.read(buffer.data(), buffer.size());
+    return buffer;
+}
+
+// Count rounds in a buffer, whitespace between hands is skipped like in stream parsing
+template <std::size_t NUM_HANDS>
+RoundHistogram<NUM_HANDS> countRounds(const char* data, std::size_t size, const Rules<NUM_HANDS>& rules) {
+    RoundHistogram<NUM_HANDS> histogram = {};
+    const char* const end = data + size;
+    auto skip_whitespace = [end](const char*& c) {
+        while (c != end && std::isspace(static_cast<unsigned char>(*c))) ++c;
+    };
+
+    const char* c = data;
+    while (skip_whitespace(c), c != end) {
+        const char c1 = *c++;
+        skip_whitespace(c);
+        if (c == end) {
+            break;
+        }
+        const char c2 = *c++;
+        const std::size_t idx = rules.index(c1, c2);
+        if (idx < histogram.size()) {
+            ++histogram[idx];
+        }
+    }
+
+    return histogram;
+}
+
+// total score is the dot product of round counts and round scores
+template <std::size_t NUM_HANDS>
+std::size_t scoreHistogram(const RoundHistogram<NUM_HANDS>& histogram, const ScoreTable<NUM_HANDS>& table) {
+    return std::inner_product(histogram.cbegin(), histogram.cend(), table.cbegin(), std::size_t{0});
+}
+
+// Packed format : header followed by one round per 4 bits, first round in the low nibble.
+// Each nibble is (opponent hand << 2) | own hand (or outcome), so up to 4 hands are supported.
+struct PackedHeader {
+    std::array<char, 3> magic = {'R', 'P', 'S'};
+    char num_hands = 0;
+    std::uint32_t reserved = 0;
+    std::uint64_t num_rounds = 0;
+};
+
+constexpr std::size_t PACKED_BITS = 2;
+
+// Pack rounds of a text buffer, whitespace is skipped like in stream parsing.
+// Returns false on invalid hands.
+template <std::size_t NUM_HANDS>
+bool packRounds(const char* data, std::size_t size, const Rules<NUM_HANDS>& rules,
+                std::vector<std::uint8_t>& packed, std::uint64_t& num_rounds) {
+    static_assert(NUM_HANDS <= (1 << PACKED_BITS), "Too many hands for packed format");
+
+    const char* const end = data + size;
+    auto skip_whitespace = [end](const char*& c) {
+        while (c != end && std::isspace(static_cast<unsigned char>(*c))) ++c;
+    };
+
+    packed.clear();
+    packed.reserve(size / 8 + 1);
+    num_rounds = 0;
+
+    const char* c = data;
+    while (skip_whitespace(c), c != end) {
+        const std::size_t opponent = static_cast<std::size_t>(*c++ - rules.first_opponent);
+        skip_whitespace(c);
+        if (c == end) {
+            break;
+        }
+        const std::size_t own = static_cast<std::size_t>(*c++ - rules.first_player);
+        if (opponent >= NUM_HANDS || own >= NUM_HANDS) {
+            return false;
+        }
+
+        const std::uint8_t nibble = (opponent << PACKED_BITS) | own;
+        if (num_rounds % 2 == 0) {
+            packed.push_back(nibble);
+        } else {
+            packed.back() |= (nibble << 4);
+        }
+        ++num_rounds;
+    }
+
+    return true;
+}
+
+// score of both rounds packed into one byte
+template <std::size_t NUM_HANDS>
+constexpr std::array<std::uint8_t, 256> makePackedPairTable(const ScoreTable<NUM_HANDS>& table) {
+    std::array<std::uint8_t, 16> nibble_scores = {};
+    for (std::size_t opponent = 0; opponent < NUM_HANDS; ++opponent) {
+        for (std::size_t own = 0; own < NUM_HANDS; ++own) {
+            nibble_scores[(opponent << PACKED_BITS) | own] = table[opponent * NUM_HANDS + own];
+        }
+    }
+
+    std::array<std::uint8_t, 256> pair_table = {};
+    for (std::size_t byte = 0; byte < pair_table.size(); ++byte) {
+        pair_table[byte] = nibble_scores[byte & 0xF] + nibble_scores[byte >> 4];
+    }
+    return pair_table;
+}
+
+std::size_t scorePacked(const std::uint8_t* packed, std::uint64_t num_rounds,
+                        const std::array<std::uint8_t, 256>& pair_table) {
+    const std::uint64_t num_full_bytes = num_rounds / 2;
+
+    // independent accumulators to not be limited by the latency of the additions
+    std::array<std::size_t, 4> sums = {};
+    std::uint64_t i = 0;
+    for (; i + sums.size() <= num_full_bytes; i += sums.size()) {
+        for (std::size_t j = 0; j < sums.size(); ++j) {
+            sums[j] += pair_table[packed[i + j]];
+        }
+    }
+    for (; i < num_full_bytes; ++i) {
+        sums[0] += pair_table[packed[i]];
+    }
+
+    // odd number of rounds : only low nibble of last byte is valid, high nibble is zero
+    // and would add the score of the first round type
+    if (num_rounds % 2 == 1) {
+        sums[0] += pair_table[packed[num_full_bytes]] - pair_table[0] / 2;
+    }
+
+    return std::accumulate(sums.cbegin(), sums.cend(), std::size_t{0});
+}
+
+template <std::size_t NUM_HANDS, const Rules<NUM_HANDS>& rules>
+int solve(std::ifstream& ifile, const std::string& filename, Part part, Method method) {
+    // generated at compile time from the rules
+    static constexpr ScoreTable<NUM_HANDS> scores_part1 = makeScoreTablePart1(rules);
+    static constexpr ScoreTable<NUM_HANDS> scores_part2 = makeScoreTablePart2(rules);
+
+    std::size_t total_score = 0;
+    if (method == Method::HISTOGRAM) {
+        const std::vector<char> buffer = readFile(ifile);
+
+        const RoundHistogram<NUM_HANDS> histogram = countRounds(buffer.data(), buffer.size(), rules);
+
+        // part 1 rule for every possible mapping of own hand labels to hands
+        std::array<std::size_t, NUM_HANDS> mapping;
+        std::iota(mapping.begin(), mapping.end(), 0);
+        do {
+            const ScoreTable<NUM_HANDS> table = permuteOwnHands(scores_part1, mapping);
+            for (std::size_t own = 0; own < NUM_HANDS; ++own) {
+                std::cout << (own == 0 ? "" : ",") << char(rules.first_player + own);
+            }
+            std::cout << " as ";
+            for (std::size_t own = 0; own < NUM_HANDS; ++own) {
+                std::cout << (own == 0 ? "" : ",") << char(rules.first_opponent + mapping[own]);
+            }
+            std::cout << ": " << scoreHistogram<NUM_HANDS>(histogram, table) << std::endl;
+        } while (std::next_permutation(mapping.begin(), mapping.end()));
+
+        std::cout << "total score part 1: " << scoreHistogram<NUM_HANDS>(histogram, scores_part1) << std::endl;
+        std::cout << "total score part 2: " << scoreHistogram<NUM_HANDS>(histogram, scores_part2) << std::endl;
+        return 0;
+    }
+
+    const ScoreTable<NUM_HANDS>& table = (part == Part::FIRST) ? scores_part1 : scores_part2;
+
+    if constexpr (NUM_HANDS <= (1 << PACKED_BITS)) {
+        if (method == Method::PACK) {
+            const std::vector<char> buffer = readFile(ifile);
+
+            PackedHeader header;
+            header.num_hands = NUM_HANDS;
+            std::vector<std::uint8_t> packed;
+            if (!packRounds(buffer.data(), buffer.size(), rules, packed, header.num_rounds)) {
+                std::cout << "Invalid hands in input" << std::endl;
+                return 1;
+            }
+
+            const std::string packed_filename = filename + ".packed";
+            std::ofstream ofile(packed_filename, std::ios::binary);
+            ofile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            ofile.write(reinterpret_cast<const char*>(packed.data()), packed.size());
+            if (!ofile.good()) {
+                std::cout << "Could not write " << packed_filename << std::endl;
+                return 1;
+            }
+
+            std::cout << "Packed " << header.num_rounds << " rounds from " << buffer.size() << " to "
+                      << sizeof(header) + packed.size() << " bytes into " << packed_filename << std::endl;
+            return 0;
+        }
+
+        if (method == Method::PACKED) {
+            static constexpr std::array<std::uint8_t, 256> pair_scores_part1 = makePackedPairTable<NUM_HANDS>(scores_part1);
+            static constexpr std::array<std::uint8_t, 256> pair_scores_part2 = makePackedPairTable<NUM_HANDS>(scores_part2);
+
+            const std::vector<char> buffer = readFile(ifile);
+
+            PackedHeader header;
+            if (buffer.size() >= sizeof(header)) {
+                std::copy(buffer.data(), buffer.data() + sizeof(header), reinterpret_cast<char*>(&header));
+            }
+            if (buffer.size() < sizeof(header) || header.magic != PackedHeader{}.magic ||
+                header.num_hands != NUM_HANDS || buffer.size() - sizeof(header) < (header.num_rounds + 1) / 2) {
+                std::cout << "Invalid packed input" << std::endl;
+                return 1;
+            }
+
+            total_score = scorePacked(reinterpret_cast<const std::uint8_t*>(buffer.data()) + sizeof(header),
+                                      header.num_rounds, (part == Part::FIRST) ? pair_scores_part1 : pair_scores_part2);
+            std::cout << "total score: " << total_score << std::endl;
+            return 0;
+        }
+    } else if (method == Method::PACK || method == Method::PACKED) {
+        std::cout << "Packed format supports up to " << (1 << PACKED_BITS) << " hands" << std::endl;
+        return 1;
+    }
+
+    if (method == Method::BUFFER) {
+        const std::vector<char> buffer = readFile(ifile);
+
+        if (scoreBuffer(buffer.data(), buffer.size(), rules, table, total_score)) {
+            std::cout << "total score: " << total_score << std::endl;
+            return 0;
+        }
+
+        // fall back to parsing the stream
+        std::cout << "Input is not fixed-width, parsing stream" << std::endl;
+        total_score = 0;
+        ifile.clear();
+        ifile.seekg(0);
+    }
+
+    char c1;
+    char c2;
+    while (ifile >> c1, ifile >> c2, ifile.good()) {
+        const std::size_t idx = rules.index(c1, c2);
+        total_score += (idx < table.size()) ? table[idx] : 0;
+    }
+
+    std::cout << "total score: " << total_score << std::endl;
+
+    return 0;
+}
+
 int main(int argc, char** argv) {
 
     if (argc < 2) {
@@ -77,37 +602,45 @@ int main(int argc, char** argv) {
         }
     }
 
+    Method method = Method::STREAM;
+    if (argc > 3) {
+        unsigned int method_value = std::atol(argv[3]);
+        if (method_value == 0) {
+            method = Method::STREAM;
+        } else if (method_value == 1) {
+            method = Method::BUFFER;
+        } else if (method_value == 2) {
+            method = Method::HISTOGRAM;
+        } else if (method_value == 3) {
+            method = Method::PACK;
+        } else if (method_value == 4) {
+            method = Method::PACKED;
+        } else {
+            std::cout << "Invalid method: " << method_value << std::endl;
+            return 1;
+        }
+    }
+
+    // optional: game variant, 0 : rock paper scissors, 1 : rock paper scissors lizard spock
+    unsigned int variant = 0;
+    if (argc > 4) {
+        variant = std::atol(argv[4]);
+        if (variant > 1) {
+            std::cout << "Invalid variant: " << variant << std::endl;
+            return 1;
+        }
+    }
+
     std::string filename = argv[1];
-    std::ifstream ifile(argv[1]);
+    std::ifstream ifile(argv[1], std::ios::binary);
 
     if (!ifile.good()) {
         std::cout << "Could not find " << filename << std::endl;
         return 1;
     }
 
-    std::size_t total_score = 0;
-    switch (part) {
-        case Part::FIRST:
-        {
-            char c1;
-            char c2;
-            while (ifile >> c1, ifile >> c2, ifile.good()) {
-                total_score += getScorePart1(c1, c2);
-            }
-        }
-        break;
-        case Part::SECOND:
-        {
-            char c1;
-            char c2;
-            while (ifile >> c1, ifile >> c2, ifile.good()) {
-                total_score += getScorePart2(c1, c2);
-            }
-        }
-        break;
+    if (variant == 1) {
+        return solve<5, ROCK_PAPER_SCISSORS_LIZARD_SPOCK>(ifile, filename, part, method);
     }
- 
-    std::cout << "total score: " << total_score << std::endl;
-
-    return 0;
-}
\ No newline at end of file
+    return solve<3, ROCK_PAPER_SCISSORS>(ifile, filename, part, method);
+}
@@ -1,9 +1,21 @@
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <bitset>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <numeric>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
 
 namespace {
     enum class Part {
@@ -11,6 +23,12 @@ namespace {
         SECOND
     };
 
+    enum class Method {
+        STREAM = 0, // process one character at a time from the file stream
+        BUFFER,     // read whole file, build item masks of whole compartments at once
+        REPORT      // list all common items for any byte items, compartments / group size
+    };
+
     int getPriority(const char c) {
         // A (65) -> Z (90) : 27-52
         // a (97) -> z (122) : 1-26
@@ -21,27 +39,367 @@ namespace {
         }
     }
 
+    // Mask of all items in [begin, end), bit (item - 'A') is set for each item.
+    // Vectorized: every byte is split into the byte (item - 'A') / 8 and the bit (item - 'A') % 8
+    // it sets in the mask. For each of the 8 mask bytes, the bits of all matching bytes are
+    // or-ed into their own accumulator, which is reduced once at the end.
+    std::uint64_t itemMask(const char* begin, const char* end) {
+        std::uint64_t mask = 0;
+        const char* c = begin;
+
+#if defined(__AVX2__)
+        static constexpr std::size_t BLOCK_SIZE = 32;
+        if (end - begin >= static_cast<std::ptrdiff_t>(BLOCK_SIZE)) {
+            const __m256i offset_v = _mm256_set1_epi8('A');
+            const __m256i low_bits_v = _mm256_set1_epi8(0x07);
+            const __m256i bit_lookup_v = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                          1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+
+            __m256i acc[8];
+            for (auto& a : acc) a = _mm256_setzero_si256();
+
+            for (; c + BLOCK_SIZE <= end; c += BLOCK_SIZE) {
+                const __m256i items = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(c)), offset_v);
+                const __m256i bits = _mm256_shuffle_epi8(bit_lookup_v, _mm256_and_si256(items, low_bits_v));
+                const __m256i bytes = _mm256_and_si256(_mm256_srli_epi16(items, 3), low_bits_v);
+                for (int k = 0; k < 8; ++k) {
+                    const __m256i match = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(k));
+                    acc[k] = _mm256_or_si256(acc[k], _mm256_and_si256(match, bits));
+                }
+            }
+
+            // reduce each accumulator to a single byte
+            for (int k = 0; k < 8; ++k) {
+                __m128i a = _mm_or_si128(_mm256_castsi256_si128(acc[k]), _mm256_extracti128_si256(acc[k], 1));
+                a = _mm_or_si128(a, _mm_srli_si128(a, 8));
+                a = _mm_or_si128(a, _mm_srli_si128(a, 4));
+                a = _mm_or_si128(a, _mm_srli_si128(a, 2));
+                a = _mm_or_si128(a, _mm_srli_si128(a, 1));
+                mask |= std::uint64_t(_mm_cvtsi128_si32(a) & 0xFF) << (8 * k);
+            }
+        }
+#elif defined(__SSSE3__)
+        static constexpr std::size_t BLOCK_SIZE = 16;
+        if (end - begin >= static_cast<std::ptrdiff_t>(BLOCK_SIZE)) {
+            const __m128i offset_v = _mm_set1_epi8('A');
+            const __m128i low_bits_v = _mm_set1_epi8(0x07);
+            const __m128i bit_lookup_v = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+
+            __m128i acc[8];
+            for (auto& a : acc) a = _mm_setzero_si128();
+
+            for (; c + BLOCK_SIZE <= end; c += BLOCK_SIZE) {
+                const __m128i items = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(c)), offset_v);
+                const __m128i bits = _mm_shuffle_epi8(bit_lookup_v, _mm_and_si128(items, low_bits_v));
+                const __m128i bytes = _mm_and_si128(_mm_srli_epi16(items, 3), low_bits_v);
+                for (int k = 0; k < 8; ++k) {
+                    const __m128i match = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(k));
+                    acc[k] = _mm_or_si128(acc[k], _mm_and_si128(match, bits));
+                }
+            }
+
+            // reduce each accumulator to a single byte
+            for (int k = 0; k < 8; ++k) {
+                __m128i a = acc[k];
+                a = _mm_or_si128(a, _mm_srli_si128(a, 8));
+                a = _mm_or_si128(a, _mm_srli_si128(a, 4));
+                a = _mm_or_si128(a, _mm_srli_si128(a, 2));
+                a = _mm_or_si128(a, _mm_srli_si128(a, 1));
+                mask |= std::uint64_t(_mm_cvtsi128_si32(a) & 0xFF) << (8 * k);
+            }
+        }
+#endif
+
+        // scalar tail (or everything if no SIMD support)
+        for (; c != end; ++c) {
+            mask |= (std::uint64_t(1) << (*c - 'A'));
+        }
+
+        return mask;
+    }
+
+    // Set of items as a bitset of ALPHABET_BITS bits. The 64 bit alphabet covers
+    // letters (bit item - 'A'), wider alphabets map each byte value to its own bit.
+    template <std::size_t ALPHABET_BITS>
+    class ItemSet {
+        public:
+            static_assert(ALPHABET_BITS % 64 == 0 && ALPHABET_BITS <= 256, "Unsupported alphabet size");
+            static constexpr char FIRST_ITEM = (ALPHABET_BITS == 64) ? 'A' : 0;
+
+            void insert(char item) {
+                const std::size_t bit = index(item);
+                words_[bit / 64] |= (std::uint64_t(1) << (bit % 64));
+            }
+
+            void insert(const char* begin, const char* end) {
+                if constexpr (WORDS == 1) {
+                    words_[0] |= itemMask(begin, end);
+                } else {
+                    // independent partial sets, to not serialize on updates of the same word
+                    std::array<std::array<std::uint64_t, WORDS>, 4> partial = {};
+                    const char* c = begin;
+                    for (; c + partial.size() <= end; c += partial.size()) {
+                        for (std::size_t j = 0; j < partial.size(); ++j) {
+                            const std::size_t bit = index(c[j]);
+                            partial[j][bit / 64] |= (std::uint64_t(1) << (bit % 64));
+                        }
+                    }
+                    for (; c != end; ++c) {
+                        insert(*c);
+                    }
+                    for (const auto& words : partial) {
+                        for (std::size_t w = 0; w < WORDS; ++w) {
+                            words_[w] |= words[w];
+                        }
+                    }
+                }
+            }
+
+            bool check(char item) const {
+                const std::size_t bit = index(item);
+                return ((words_[bit / 64] & (std::uint64_t(1) << (bit % 64))) > 0);
+            }
+
+            // only keep items which are also in other set
+            void intersect(const ItemSet& other) {
+#if defined(__AVX2__)
+                if constexpr (WORDS == 4) {
+                    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words_.data()));
+                    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(other.words_.data()));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(words_.data()), _mm256_and_si256(a, b));
+                    return;
+                }
+#endif
+                for (std::size_t w = 0; w < WORDS; ++w) {
+                    words_[w] &= other.words_[w];
+                }
+            }
+
+            bool empty() const {
+                for (const std::uint64_t word : words_) {
+                    if (word != 0) return false;
+                }
+                return true;
+            }
+
+            // lowest item in the set, set must not be empty
+            char first() const {
+                for (std::size_t w = 0; w < WORDS; ++w) {
+                    if (words_[w] != 0) {
+                        return item(w * 64 + std::countr_zero(words_[w]));
+                    }
+                }
+                return 0;
+            }
+
+            // all items in the set, in increasing order
+            std::string items() const {
+                std::string all;
+                for (std::size_t w = 0; w < WORDS; ++w) {
+                    for (std::uint64_t word = words_[w]; word != 0; word &= word - 1) {
+                        all.push_back(item(w * 64 + std::countr_zero(word)));
+                    }
+                }
+                return all;
+            }
+
+            void clear() {
+                words_ = {};
+            }
+
+        private:
+            static constexpr std::size_t WORDS = ALPHABET_BITS / 64;
+
+            static std::size_t index(char item) {
+                return static_cast<unsigned char>(item - FIRST_ITEM) % ALPHABET_BITS;
+            }
+
+            static char item(std::size_t index) {
+                return static_cast<char>(FIRST_ITEM + index);
+            }
+
+            std::array<std::uint64_t, WORDS> words_ = {};
+    };
+
+    // Rucksack split into COMPARTMENTS equally sized compartments, elves are grouped by GROUP_SIZE
+    template <std::size_t ALPHABET_BITS = 64, std::size_t COMPARTMENTS = 2, std::size_t GROUP_SIZE = 3>
     struct Rucksack {
         public:
+            using Items = ItemSet<ALPHABET_BITS>;
+            static constexpr std::size_t NUM_COMPARTMENTS = COMPARTMENTS;
+            static constexpr std::size_t NUM_GROUP_MEMBERS = GROUP_SIZE;
+
             // put item into rucksack
             void insert(char item) {
-                content_ |= (std::uint64_t(1) << (item - 'A'));
-                //           std::cout << "Adding " << char(item) << "(" << (item - 'A') << "), current compartment: " << std::bitset<64>(content_).to_string() << std::endl;
+                content_.insert(item);
+            }
+
+            // put all items in [begin, end) into rucksack
+            void insert(const char* begin, const char* end) {
+                content_.insert(begin, end);
+            }
+
+            // only keep items which are also in other rucksack
+            void intersect(const Rucksack& other) {
+                content_.intersect(other.content_);
+            }
+
+            bool empty() const {
+                return content_.empty();
+            }
+
+            // any item that is present in rucksack, rucksack must not be empty
+            char first() const {
+                return content_.first();
             }
 
             // check if item is already present in rucksack
             bool check(char item) const {
-                return ((content_ & (std::uint64_t(1) << (item - 'A'))) > 0);
+                return content_.check(item);
+            }
+
+            const Items& content() const {
+                return content_;
             }
 
             // dump content of rucksack
             void clear() {
-                content_ = 0;
+                content_.clear();
             }
 
         private:
-            std::uint64_t content_ = 0;
+            Items content_;
     };
+
+    // end of line starting at begin (or end of buffer)
+    const char* findEol(const char* begin, const char* end) {
+        const void* eol = std::memchr(begin, '\n', end - begin);
+        return (eol == nullptr) ? end : static_cast<const char*>(eol);
+    }
+
+    // Call on_common with the items common to all compartments of each line (part 1)
+    // or common to all lines of each group (part 2) in [begin, end)
+    template <typename RucksackT, typename Callback>
+    void forEachCommon(const char* begin, const char* end, Part part, Callback&& on_common) {
+        const char* line = begin;
+
+        switch (part) {
+            case Part::FIRST:
+            {
+                while (line < end) {
+                    const char* eol = findEol(line, end);
+                    const std::size_t items_per_compartment = (eol - line) / RucksackT::NUM_COMPARTMENTS;
+
+                    RucksackT rucksack_common;
+                    rucksack_common.insert(line, line + items_per_compartment);
+                    for (std::size_t i = 1; i < RucksackT::NUM_COMPARTMENTS; ++i) {
+                        RucksackT compartment;
+                        compartment.insert(line + i * items_per_compartment, line + (i + 1) * items_per_compartment);
+                        rucksack_common.intersect(compartment);
+                    }
+                    on_common(rucksack_common);
+
+                    line = eol + 1;
+                }
+            }
+            break;
+            case Part::SECOND:
+            {
+                while (line < end) {
+                    RucksackT rucksack_common;
+                    rucksack_common.insert(line, findEol(line, end));
+                    for (std::size_t elf = 1; elf < RucksackT::NUM_GROUP_MEMBERS; ++elf) {
+                        line = findEol(line, end) + 1;
+                        RucksackT rucksack;
+                        if (line < end) {
+                            rucksack.insert(line, findEol(line, end));
+                        }
+                        rucksack_common.intersect(rucksack);
+                    }
+                    on_common(rucksack_common);
+
+                    line = findEol(std::min(line, end), end) + 1;
+                }
+            }
+            break;
+        }
+    }
+
+    // sum of priorities of all lines (part 1) or groups of lines (part 2) in [begin, end)
+    template <typename RucksackT = Rucksack<>>
+    std::uint64_t sumPriorities(const char* begin, const char* end, Part part) {
+        std::uint64_t sum_priorities = 0;
+        forEachCommon<RucksackT>(begin, end, part, [&sum_priorities](const RucksackT& rucksack_common) {
+            if (!rucksack_common.empty()) {
+                sum_priorities += getPriority(rucksack_common.first());
+            }
+        });
+
+        return sum_priorities;
+    }
+
+    // Split buffer into num_threads chunks of whole lines (whole groups of lines for
+    // part 2) and sum up the priorities of each chunk in its own thread
+    template <typename RucksackT = Rucksack<>>
+    std::uint64_t parallelSumPriorities(const char* begin, const char* end, Part part, std::size_t num_threads) {
+        std::vector<const char*> line_starts;
+        for (const char* line = begin; line < end; line = findEol(line, end) + 1) {
+            line_starts.push_back(line);
+        }
+
+        const std::size_t group_size = (part == Part::FIRST) ? 1 : RucksackT::NUM_GROUP_MEMBERS;
+        const std::size_t num_groups = (line_starts.size() + group_size - 1) / group_size;
+        const std::size_t groups_per_chunk = (num_groups + num_threads - 1) / num_threads;
+        const std::size_t lines_per_chunk = groups_per_chunk * group_size;
+
+        std::vector<std::uint64_t> partial_sums(num_threads, 0);
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < num_threads && i * lines_per_chunk < line_starts.size(); ++i) {
+            const char* chunk_begin = line_starts[i * lines_per_chunk];
+            const char* chunk_end = ((i + 1) * lines_per_chunk < line_starts.size()) ? line_starts[(i + 1) * lines_per_chunk] : end;
+
+            workers.emplace_back([&partial_sums, i, chunk_begin, chunk_end, part]() {
+                partial_sums[i] = sumPriorities<RucksackT>(chunk_begin, chunk_end, part);
+            });
+        }
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        return std::accumulate(partial_sums.cbegin(), partial_sums.cend(), std::uint64_t{0});
+    }
+
+    // List all common items of each line (part 1) or group (part 2), for full byte alphabets
+    template <std::size_t COUNT>
+    void reportCommonItems(const char* begin, const char* end, Part part) {
+        // the count is the number of compartments in part 1, the group size in part 2
+        using RucksackT = Rucksack<256, COUNT, COUNT>;
+
+        std::size_t record = 0;
+        std::size_t num_with_common = 0;
+        forEachCommon<RucksackT>(begin, end, part, [&](const RucksackT& rucksack_common) {
+            const std::string items = rucksack_common.content().items();
+            std::cout << record++ << ": " << items << std::endl;
+            num_with_common += !items.empty();
+        });
+
+        std::cout << "Records with common items: " << num_with_common << " / " << record << std::endl;
+    }
+
+    // call f with std::integral_constant of n, for n in [N, MAX]
+    template <std::size_t N, std::size_t MAX, typename F>
+    bool dispatchCount(std::size_t n, F&& f) {
+        if constexpr (N > MAX) {
+            return false;
+        } else {
+            if (n == N) {
+                f(std::integral_constant<std::size_t, N>{});
+                return true;
+            }
+            return dispatchCount<N + 1, MAX>(n, f);
+        }
+    }
 }
 
 // Note 1: This is not cross platform compatible, I am assuming that eol == '\n'
@@ -66,6 +424,36 @@ int main(int argc, char** argv) {
         }
     }
 
+    Method method = Method::STREAM;
+    if (argc > 3) {
+        unsigned int method_value = std::atol(argv[3]);
+        if (method_value == 0) {
+            method = Method::STREAM;
+        } else if (method_value == 1) {
+            method = Method::BUFFER;
+        } else if (method_value == 2) {
+            method = Method::REPORT;
+        } else {
+            std::cout << "Invalid method: " << method_value << std::endl;
+            return 1;
+        }
+    }
+
+    // optional: number of threads for buffer method, 0 for one per hardware thread
+    std::size_t num_threads = 1;
+    if (argc > 4) {
+        num_threads = std::atol(argv[4]);
+        if (num_threads == 0) {
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+    }
+
+    // optional: for report method, number of compartments (part 1) or group size (part 2)
+    std::size_t count = (part == Part::FIRST) ? 2 : 3;
+    if (argc > 5) {
+        count = std::atol(argv[5]);
+    }
+
     std::string filename = argv[1];
     std::ifstream ifile(argv[1]);
 
@@ -74,10 +462,40 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    Rucksack rucksack;
-    Rucksack rucksack_common;
+    Rucksack<> rucksack;
+    Rucksack<> rucksack_common;
     std::uint64_t sum_priorities = 0;
 
+    if (method == Method::BUFFER || method == Method::REPORT) {
+        ifile.seekg(0, std::ios::end);
+        std::vector<char> buffer(ifile.tellg());
+        ifile.seekg(0);
+        ifile.read(buffer.data(), buffer.size());
+
+        const char* begin = buffer.data();
+        const char* end = begin + buffer.size();
+        if (method == Method::REPORT) {
+            static constexpr std::size_t MAX_COUNT = 8;
+            const bool valid_count = dispatchCount<1, MAX_COUNT>(count, [&](auto count_constant) {
+                reportCommonItems<decltype(count_constant)::value>(begin, end, part);
+            });
+            if (!valid_count) {
+                std::cout << "Invalid compartment / group size: " << count << std::endl;
+                return 1;
+            }
+            return 0;
+        }
+
+        if (num_threads > 1) {
+            sum_priorities = parallelSumPriorities(begin, end, part, num_threads);
+        } else {
+            sum_priorities = sumPriorities(begin, end, part);
+        }
+
+        std::cout << "total score: " << sum_priorities << std::endl;
+        return 0;
+    }
+
     switch (part) {
         case Part::FIRST:
         {
@@ -1,12 +1,28 @@
+#include <algorithm>
+#include <bit>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 namespace {
 enum class Part { FIRST = 0, SECOND };
 
+enum class Method {
+  STREAM = 0,  // parse and check one assignment at a time from the file stream
+  BATCH,       // parse whole file into arrays, check all assignments at once
+  QUERY,       // answer section coverage queries from a second file
+  COVERAGE     // coverage statistics over all elf ranges
+};
+
 struct Assignment {
   bool parse(std::ifstream& ifile) {
     // format is <value>-<value>,<value>-<value>
@@ -34,6 +50,86 @@ struct Assignment {
   std::pair<uint16_t, uint16_t> elf_0;
   std::pair<uint16_t, uint16_t> elf_1;
 };
+
+// All assignments as structure of arrays
+struct Assignments {
+  // parse buffer of <value>-<value>,<value>-<value> lines
+  void parse(const char* begin, const char* end);
+
+  std::size_t size() const { return start_0.size(); }
+
+  std::vector<uint16_t> start_0;
+  std::vector<uint16_t> end_0;
+  std::vector<uint16_t> start_1;
+  std::vector<uint16_t> end_1;
+};
+
+// part 1 : number of pairs where one range contains the other
+std::size_t countContained(const Assignments& assignments);
+
+// part 2 : number of pairs where the ranges overlap
+std::size_t countOverlapping(const Assignments& assignments);
+
+// Static index over all elf ranges of all assignments. Range i belongs to elf i % 2
+// of assignment i / 2.
+class IntervalIndex {
+ public:
+  IntervalIndex(const Assignments& assignments);
+
+  // number of ranges containing section
+  std::size_t countCovering(uint16_t section) const;
+
+  // number of ranges overlapping [first, last]
+  std::size_t countOverlapping(uint16_t first, uint16_t last) const;
+
+  // ids of all ranges containing section
+  std::vector<std::size_t> findCovering(uint16_t section) const;
+
+ private:
+  struct Range {
+    uint16_t first;
+    uint16_t last;
+    std::size_t id;
+  };
+
+  // maximum last section in the subtree of the implicit tree over [begin, end)
+  uint16_t buildMaxLast(std::size_t begin, std::size_t end);
+
+  void findCovering(std::size_t begin, std::size_t end, uint16_t section,
+                    std::vector<std::size_t>& ids) const;
+
+  // sorted first and last sections, for counting
+  std::vector<uint16_t> firsts_;
+  std::vector<uint16_t> lasts_;
+
+  // Ranges sorted by first section, seen as implicit balanced binary tree: the root of
+  // [begin, end) is the middle element. max_last_ holds the maximum last section of the
+  // subtree rooted at each element, so that subtrees ending before a section are skipped.
+  std::vector<Range> ranges_;
+  std::vector<uint16_t> max_last_;
+};
+
+// Queries are lines of either
+//   point <section>         : list ranges covering section
+//   range <first> <last>    : count ranges overlapping [first, last]
+bool answerQueries(const IntervalIndex& index, std::ifstream& query_file);
+
+struct CoverageStats {
+  // number of sections covered by at least one range
+  std::size_t covered_sections = 0;
+
+  // maximum number of ranges covering the same section, and first such section
+  std::size_t max_depth = 0;
+  uint16_t max_depth_section = 0;
+
+  // uncovered sections between the first and last covered section, as [first, last]
+  std::vector<std::pair<uint16_t, uint16_t>> gaps;
+};
+
+// Sweep over all sections with a difference array (+1 at first section, -1 after last
+// section of each range). Building the difference array and its prefix sum are split
+// over num_threads threads.
+CoverageStats computeCoverage(const Assignments& assignments, std::size_t num_threads);
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -55,14 +151,91 @@ int main(int argc, char** argv) {
     }
   }
 
+  Method method = Method::STREAM;
+  if (argc > 3) {
+    unsigned int method_value = std::atol(argv[3]);
+    if (method_value == 0) {
+      method = Method::STREAM;
+    } else if (method_value == 1) {
+      method = Method::BATCH;
+    } else if (method_value == 2) {
+      method = Method::QUERY;
+    } else if (method_value == 3) {
+      method = Method::COVERAGE;
+    } else {
+      std::cout << "Invalid method: " << method_value << std::endl;
+      return 1;
+    }
+  }
+
+  if (method == Method::QUERY && argc < 5) {
+    std::cout << "Please provide query file" << std::endl;
+    return 1;
+  }
+
   std::string filename = argv[1];
-  std::ifstream ifile(argv[1]);
+  std::ifstream ifile(argv[1], std::ios::binary);
 
   if (!ifile.good()) {
     std::cout << "Could not find " << filename << std::endl;
     return 1;
   }
 
+  if (method != Method::STREAM) {
+    ifile.seekg(0, std::ios::end);
+    std::vector<char> buffer(ifile.tellg());
+    ifile.seekg(0);
+    ifile.read(buffer.data(), buffer.size());
+
+    Assignments assignments;
+    assignments.parse(buffer.data(), buffer.data() + buffer.size());
+
+    if (method == Method::COVERAGE) {
+      // optional: number of threads, 0 for one per hardware thread
+      std::size_t num_threads = 1;
+      if (argc > 4) {
+        num_threads = std::atol(argv[4]);
+        if (num_threads == 0) {
+          num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+      }
+
+      const CoverageStats stats = computeCoverage(assignments, num_threads);
+      std::cout << "Covered sections: " << stats.covered_sections << std::endl;
+      std::cout << "Maximum depth: " << stats.max_depth << " (first at section "
+                << stats.max_depth_section << ")" << std::endl;
+      std::cout << "Uncovered gaps: " << stats.gaps.size();
+      for (const auto& gap : stats.gaps) {
+        std::cout << " " << gap.first << "-" << gap.second;
+      }
+      std::cout << std::endl;
+      return 0;
+    }
+
+    if (method == Method::QUERY) {
+      std::ifstream query_file(argv[4]);
+      if (!query_file.good()) {
+        std::cout << "Could not find " << argv[4] << std::endl;
+        return 1;
+      }
+
+      IntervalIndex index(assignments);
+      return answerQueries(index, query_file) ? 0 : 1;
+    }
+
+    switch (part) {
+      case Part::FIRST:
+        std::cout << "Number of assigned pairs containing each other: "
+                  << countContained(assignments) << std::endl;
+        break;
+      case Part::SECOND:
+        std::cout << "Number of overlapping pairs: " << countOverlapping(assignments)
+                  << std::endl;
+        break;
+    }
+    return 0;
+  }
+
   Assignment assignment;
   switch (part) {
     case Part::FIRST: {
@@ -100,3 +273,333 @@ int main(int argc, char** argv) {
 
   return 0;
 }
+
+namespace {
+void Assignments::parse(const char* begin, const char* end) {
+  // every line holds 4 values, one per array
+  const std::size_t expected_size = (end - begin) / 12 + 1;
+  for (auto* values : {&start_0, &end_0, &start_1, &end_1}) {
+    values->clear();
+    values->reserve(expected_size);
+  }
+
+  const char* c = begin;
+  auto parse_value = [&c, end](uint16_t& value) {
+    while (c != end && (*c < '0' || *c > '9')) ++c;
+    if (c == end) return false;
+
+    value = 0;
+    for (; c != end && *c >= '0' && *c <= '9'; ++c) {
+      value = value * 10 + (*c - '0');
+    }
+    return true;
+  };
+
+  uint16_t s0, e0, s1, e1;
+  while (parse_value(s0) && parse_value(e0) && parse_value(s1) && parse_value(e1)) {
+    start_0.push_back(s0);
+    end_0.push_back(e0);
+    start_1.push_back(s1);
+    end_1.push_back(e1);
+  }
+}
+
+// Both counts evaluate the same predicates as the stream solution without branches,
+// the AVX2 version compares 16 assignments at once (a <= b as max(a, b) == b)
+// and counts the matching 16 bit lanes with a popcount of the byte mask.
+std::size_t countContained(const Assignments& assignments) {
+  const uint16_t* s0 = assignments.start_0.data();
+  const uint16_t* e0 = assignments.end_0.data();
+  const uint16_t* s1 = assignments.start_1.data();
+  const uint16_t* e1 = assignments.end_1.data();
+
+  std::size_t counter = 0;
+  std::size_t i = 0;
+
+#if defined(__AVX2__)
+  auto less_equal = [](__m256i a, __m256i b) {
+    return _mm256_cmpeq_epi16(_mm256_max_epu16(a, b), b);
+  };
+  auto load = [](const uint16_t* values) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+  };
+
+  std::size_t matching_bytes = 0;
+  for (; i + 16 <= assignments.size(); i += 16) {
+    const __m256i vs0 = load(s0 + i);
+    const __m256i ve0 = load(e0 + i);
+    const __m256i vs1 = load(s1 + i);
+    const __m256i ve1 = load(e1 + i);
+
+    const __m256i first_contains = _mm256_and_si256(less_equal(vs0, vs1), less_equal(ve1, ve0));
+    const __m256i second_contains = _mm256_and_si256(less_equal(vs1, vs0), less_equal(ve0, ve1));
+    const __m256i contained = _mm256_or_si256(first_contains, second_contains);
+    matching_bytes += std::popcount(static_cast<uint32_t>(_mm256_movemask_epi8(contained)));
+  }
+  counter = matching_bytes / 2;
+#endif
+
+  for (; i < assignments.size(); ++i) {
+    counter += ((s0[i] <= s1[i]) & (e0[i] >= e1[i])) | ((s1[i] <= s0[i]) & (e1[i] >= e0[i]));
+  }
+
+  return counter;
+}
+
+std::size_t countOverlapping(const Assignments& assignments) {
+  const uint16_t* s0 = assignments.start_0.data();
+  const uint16_t* e0 = assignments.end_0.data();
+  const uint16_t* s1 = assignments.start_1.data();
+  const uint16_t* e1 = assignments.end_1.data();
+
+  std::size_t counter = 0;
+  std::size_t i = 0;
+
+#if defined(__AVX2__)
+  auto less_equal = [](__m256i a, __m256i b) {
+    return _mm256_cmpeq_epi16(_mm256_max_epu16(a, b), b);
+  };
+  auto load = [](const uint16_t* values) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+  };
+
+  std::size_t matching_bytes = 0;
+  for (; i + 16 <= assignments.size(); i += 16) {
+    const __m256i vs0 = load(s0 + i);
+    const __m256i ve0 = load(e0 + i);
+    const __m256i vs1 = load(s1 + i);
+    const __m256i ve1 = load(e1 + i);
+
+    const __m256i first_overlaps = _mm256_and_si256(less_equal(vs0, vs1), less_equal(vs1, ve0));
+    const __m256i second_overlaps = _mm256_and_si256(less_equal(vs1, vs0), less_equal(vs0, ve1));
+    const __m256i overlapping = _mm256_or_si256(first_overlaps, second_overlaps);
+    matching_bytes += std::popcount(static_cast<uint32_t>(_mm256_movemask_epi8(overlapping)));
+  }
+  counter = matching_bytes / 2;
+#endif
+
+  for (; i < assignments.size(); ++i) {
+    counter += ((s0[i] <= s1[i]) & (e0[i] >= s1[i])) | ((s1[i] <= s0[i]) & (e1[i] >= s0[i]));
+  }
+
+  return counter;
+}
+
+IntervalIndex::IntervalIndex(const Assignments& assignments) {
+  const std::size_t num_ranges = 2 * assignments.size();
+  firsts_.reserve(num_ranges);
+  lasts_.reserve(num_ranges);
+  ranges_.reserve(num_ranges);
+
+  for (std::size_t i = 0; i < assignments.size(); ++i) {
+    ranges_.push_back({assignments.start_0[i], assignments.end_0[i], 2 * i});
+    ranges_.push_back({assignments.start_1[i], assignments.end_1[i], 2 * i + 1});
+  }
+
+  for (const Range& range : ranges_) {
+    firsts_.push_back(range.first);
+    lasts_.push_back(range.last);
+  }
+  std::sort(firsts_.begin(), firsts_.end());
+  std::sort(lasts_.begin(), lasts_.end());
+
+  std::sort(ranges_.begin(), ranges_.end(),
+            [](const Range& a, const Range& b) { return a.first < b.first; });
+  max_last_.resize(ranges_.size());
+  buildMaxLast(0, ranges_.size());
+}
+
+std::size_t IntervalIndex::countCovering(uint16_t section) const {
+  // ranges starting at or before section, minus those which already ended
+  const std::size_t started =
+      std::upper_bound(firsts_.cbegin(), firsts_.cend(), section) - firsts_.cbegin();
+  const std::size_t ended =
+      std::lower_bound(lasts_.cbegin(), lasts_.cend(), section) - lasts_.cbegin();
+  return started - ended;
+}
+
+std::size_t IntervalIndex::countOverlapping(uint16_t first, uint16_t last) const {
+  // all ranges, minus those ending before first and those starting after last
+  const std::size_t ended_before =
+      std::lower_bound(lasts_.cbegin(), lasts_.cend(), first) - lasts_.cbegin();
+  const std::size_t started_after =
+      firsts_.cend() - std::upper_bound(firsts_.cbegin(), firsts_.cend(), last);
+  return firsts_.size() - ended_before - started_after;
+}
+
+std::vector<std::size_t> IntervalIndex::findCovering(uint16_t section) const {
+  std::vector<std::size_t> ids;
+  findCovering(0, ranges_.size(), section, ids);
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+uint16_t IntervalIndex::buildMaxLast(std::size_t begin, std::size_t end) {
+  if (begin >= end) {
+    return 0;
+  }
+
+  const std::size_t mid = begin + (end - begin) / 2;
+  max_last_[mid] =
+      std::max({ranges_[mid].last, buildMaxLast(begin, mid), buildMaxLast(mid + 1, end)});
+  return max_last_[mid];
+}
+
+void IntervalIndex::findCovering(std::size_t begin, std::size_t end, uint16_t section,
+                                 std::vector<std::size_t>& ids) const {
+  if (begin >= end) {
+    return;
+  }
+
+  const std::size_t mid = begin + (end - begin) / 2;
+  if (max_last_[mid] < section) {
+    // all ranges of subtree end before section
+    return;
+  }
+
+  findCovering(begin, mid, section, ids);
+
+  // right subtree only has ranges starting after mid
+  if (ranges_[mid].first <= section) {
+    if (ranges_[mid].last >= section) {
+      ids.push_back(ranges_[mid].id);
+    }
+    findCovering(mid + 1, end, section, ids);
+  }
+}
+
+bool answerQueries(const IntervalIndex& index, std::ifstream& query_file) {
+  std::string query;
+  while (query_file >> query) {
+    if (query == "point") {
+      uint16_t section;
+      query_file >> section;
+
+      std::cout << "section " << section << ": " << index.countCovering(section)
+                << " ranges:";
+      for (const std::size_t id : index.findCovering(section)) {
+        std::cout << " " << id / 2 << "." << id % 2;
+      }
+      std::cout << std::endl;
+    } else if (query == "range") {
+      uint16_t first;
+      uint16_t last;
+      query_file >> first >> last;
+
+      std::cout << "sections " << first << "-" << last << ": "
+                << index.countOverlapping(first, last) << " overlapping ranges" << std::endl;
+    } else {
+      std::cout << "Unexpected query: " << query << std::endl;
+      return false;
+    }
+
+    if (query_file.fail()) {
+      std::cout << "Invalid arguments for query " << query << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+CoverageStats computeCoverage(const Assignments& assignments, std::size_t num_threads) {
+  // one entry per section plus one for the end of ranges ending at the last section
+  static constexpr std::size_t DIFF_SIZE = std::numeric_limits<uint16_t>::max() + 2;
+
+  // per thread difference arrays over a chunk of the assignments
+  std::vector<std::vector<int32_t>> diffs(num_threads, std::vector<int32_t>(DIFF_SIZE, 0));
+  const std::size_t assignments_per_thread = (assignments.size() + num_threads - 1) / num_threads;
+
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t < num_threads; ++t) {
+    workers.emplace_back([&, t]() {
+      std::vector<int32_t>& diff = diffs[t];
+      const std::size_t end = std::min(assignments.size(), (t + 1) * assignments_per_thread);
+      for (std::size_t i = t * assignments_per_thread; i < end; ++i) {
+        ++diff[assignments.start_0[i]];
+        --diff[assignments.end_0[i] + 1];
+        ++diff[assignments.start_1[i]];
+        --diff[assignments.end_1[i] + 1];
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+
+  // parallel prefix sum over blocks of sections: each thread merges the difference arrays
+  // of its block and computes the local prefix sum, block offsets are added afterwards
+  const std::size_t sections_per_block = (DIFF_SIZE + num_threads - 1) / num_threads;
+  std::vector<int32_t> depth(DIFF_SIZE, 0);
+  std::vector<int64_t> block_totals(num_threads, 0);
+
+  for (std::size_t t = 0; t < num_threads; ++t) {
+    workers.emplace_back([&, t]() {
+      const std::size_t end = std::min(DIFF_SIZE, (t + 1) * sections_per_block);
+      int64_t running = 0;
+      for (std::size_t section = t * sections_per_block; section < end; ++section) {
+        for (const auto& diff : diffs) {
+          running += diff[section];
+        }
+        depth[section] = running;
+      }
+      block_totals[t] = running;
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+
+  std::vector<int64_t> block_offsets(num_threads, 0);
+  for (std::size_t t = 1; t < num_threads; ++t) {
+    block_offsets[t] = block_offsets[t - 1] + block_totals[t - 1];
+  }
+
+  // per block statistics
+  std::vector<CoverageStats> block_stats(num_threads);
+  for (std::size_t t = 0; t < num_threads; ++t) {
+    workers.emplace_back([&, t]() {
+      CoverageStats& stats = block_stats[t];
+      const std::size_t end = std::min(DIFF_SIZE - 1, (t + 1) * sections_per_block);
+      for (std::size_t section = t * sections_per_block; section < end; ++section) {
+        depth[section] += block_offsets[t];
+        stats.covered_sections += (depth[section] > 0);
+        if (static_cast<std::size_t>(depth[section]) > stats.max_depth) {
+          stats.max_depth = depth[section];
+          stats.max_depth_section = section;
+        }
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  CoverageStats stats;
+  for (const CoverageStats& block : block_stats) {
+    stats.covered_sections += block.covered_sections;
+    if (block.max_depth > stats.max_depth) {
+      stats.max_depth = block.max_depth;
+      stats.max_depth_section = block.max_depth_section;
+    }
+  }
+
+  // gaps between first and last covered section
+  std::size_t first_covered = 0;
+  while (first_covered < DIFF_SIZE - 1 && depth[first_covered] == 0) ++first_covered;
+  std::size_t last_covered = DIFF_SIZE - 2;
+  while (last_covered > first_covered && depth[last_covered] == 0) --last_covered;
+
+  for (std::size_t section = first_covered; section < last_covered; ++section) {
+    if (depth[section] == 0) {
+      const std::size_t gap_begin = section;
+      while (depth[section + 1] == 0) ++section;
+      stats.gaps.emplace_back(gap_begin, section);
+    }
+  }
+
+  return stats;
+}
+}  // namespace
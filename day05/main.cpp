@@ -1,8 +1,10 @@
+#include <algorithm>
+#include <array>
 #include <cctype>
+#include <cmath>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
-#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -11,26 +13,39 @@
 namespace {
 enum class Part { FIRST = 0, SECOND };
 
+enum class Method {
+  SIMULATE = 0,  // move crates instruction by instruction
+  REVERSE,       // trace final top positions backwards through the instructions
+  HISTORY,       // dump stacks at given instruction indices using snapshots
+  OPTIMIZE       // simulate after merging and cancelling redundant instructions
+};
+
 struct MoveInstruction {
   int from = 0;
   int to = 0;
   int num_crates = 0;
 };
 
+// Move the top num_crates crates of one stack (bottom crate first) onto
+// another, one crate at a time or as a group. Moving onto the same stack does
+// not change it.
+void moveCratesIndividual(std::vector<char>& from, std::vector<char>& to,
+                          int num_crates);
+
+void moveCratesGrouped(std::vector<char>& from, std::vector<char>& to,
+                       int num_crates);
+
 // Note: Ids start at 1
 class Graph {
  public:
-  struct Node {
-    Node(char c) : name{c} {}
-
-    std::unique_ptr<Node> next = nullptr;
-    char name;
-  };
-
   Graph(std::size_t num_nodes);
 
+  // add crate below the current bottom of a stack, only used for construction
   void pushNode(const int root_id, const char c);
 
+  // has to be called once all crates were pushed
+  void finalize();
+
   void moveIndividual(const MoveInstruction& instruction);
 
   void moveGrouped(const MoveInstruction& instruction);
@@ -41,18 +56,108 @@ class Graph {
 
   bool empty() const;
 
+  // number of stacks, including the unused stack 0
+  std::size_t size() const;
+
+  std::size_t height(const int root_id) const;
+
+  // crates of a stack, bottom crate first
+  const std::vector<char>& stack(const int root_id) const;
+
+  // crate at depth below the top of a stack (0 : top crate)
+  char crate(const int root_id, const std::size_t depth) const;
+
  private:
-  // top of crates
-  std::vector<std::unique_ptr<Node>> roots_;
+  // contiguous stacks of crates, bottom crate first and top crate last
+  // (top crate first during construction)
+  std::vector<std::vector<char>> stacks_;
+};
+
+std::vector<char> readFile(std::ifstream& ifile);
+
+// Parse the stack layout at the start of the buffer. Stack ids are taken from
+// the label line and crates are assigned to the closest label, so any number of
+// stacks with multi-digit labels is supported. pos is moved past the layout and
+// the empty line after it.
+Graph readGraph(const std::vector<char>& buffer, std::size_t& pos);
+
+// Parse all "move X from A to B" lines starting at pos
+std::vector<MoveInstruction> parseInstructions(const std::vector<char>& buffer,
+                                               std::size_t pos);
+
+// Equivalent shorter program for valid instructions: moves without effect are
+// dropped, moves which are undone right away cancel and consecutive moves are
+// merged where the way crates are moved in the given part allows it.
+std::vector<MoveInstruction> optimizeInstructions(
+    const std::vector<MoveInstruction>& instructions, Part part);
+
+// Top crates of all stacks after applying instructions to graph (same format
+// as Graph::printRoots), without moving any crates. Each final top position is
+// traced backwards through the instructions to its position in the initial
+// graph.
+std::string traceRoots(const Graph& graph,
+                       const std::vector<MoveInstruction>& instructions,
+                       Part part);
+
+// Stacks stored as fixed-size chunks of crates which are copied on write.
+// Copies of SharedStacks share all chunks, a move only copies the partially
+// filled top chunk of the stack it pushes onto, so copies share everything
+// below the moved crates.
+class SharedStacks {
+ public:
+  SharedStacks(const Graph& graph);
+
+  void apply(const MoveInstruction& instruction, Part part);
+
+  // print stacks top to bottom like Graph::print, all stacks if root_id is 0
+  void print(const int root_id) const;
+
+ private:
+  static constexpr std::size_t CHUNK_SIZE = 256;
+  using Chunk = std::array<char, CHUNK_SIZE>;
+
+  struct Stack {
+    // chunk i holds crates [i * CHUNK_SIZE, (i + 1) * CHUNK_SIZE),
+    // bottom crate first
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    std::size_t height = 0;
+  };
+
+  // copy the top num_crates crates of a stack to moved_, bottom crate first
+  void readTop(const Stack& stack, std::size_t num_crates);
+
+  void pop(Stack& stack, std::size_t num_crates);
 
-  // non-owning pointers to bottom node of each stack of crates
-  // only used for construction of graph, not maintained later
-  std::vector<Node*> ends_;
+  // push moved_ onto a stack, chunks which are still shared are copied before
+  // writing
+  void push(Stack& stack);
+
+  std::vector<Stack> stacks_;
+
+  // crates of the current move
+  std::vector<char> moved_;
 };
 
-Graph readGraph(std::ifstream& ifile);
+// Snapshots of the stacks after every interval instructions. Snapshots share
+// all chunks of crates which were not moved in between, any state is restored
+// from the closest earlier snapshot by replaying at most interval - 1
+// instructions.
+class History {
+ public:
+  History(const Graph& graph, const std::vector<MoveInstruction>& instructions,
+          Part part, std::size_t interval);
+
+  // stacks after the first num_applied instructions
+  SharedStacks at(std::size_t num_applied) const;
 
-bool parseInstruction(std::ifstream& ifile, MoveInstruction& instruction);
+  std::size_t numSnapshots() const;
+
+ private:
+  const std::vector<MoveInstruction>& instructions_;
+  Part part_;
+  std::size_t interval_;
+  std::vector<SharedStacks> snapshots_;
+};
 
 }  // namespace
 
@@ -75,6 +180,23 @@ int main(int argc, char** argv) {
     }
   }
 
+  Method method = Method::SIMULATE;
+  if (argc > 3) {
+    unsigned int method_value = std::atol(argv[3]);
+    if (method_value == 0) {
+      method = Method::SIMULATE;
+    } else if (method_value == 1) {
+      method = Method::REVERSE;
+    } else if (method_value == 2) {
+      method = Method::HISTORY;
+    } else if (method_value == 3) {
+      method = Method::OPTIMIZE;
+    } else {
+      std::cout << "Invalid method: " << method_value << std::endl;
+      return 1;
+    }
+  }
+
   std::string filename = argv[1];
   std::ifstream ifile(argv[1]);
 
@@ -83,7 +205,9 @@ int main(int argc, char** argv) {
     return 1;
   }
 
-  Graph graph = readGraph(ifile);
+  const std::vector<char> buffer = readFile(ifile);
+  std::size_t pos = 0;
+  Graph graph = readGraph(buffer, pos);
 
   if (graph.empty()) {
     std::cout << "Graph was empty" << std::endl;
@@ -92,17 +216,78 @@ int main(int argc, char** argv) {
 
   graph.print();
 
+  std::vector<MoveInstruction> instructions = parseInstructions(buffer, pos);
+
+  if (method == Method::REVERSE || method == Method::HISTORY) {
+    if (method == Method::HISTORY) {
+      // optional: snapshot interval, 0 for sqrt of number of instructions
+      std::size_t interval = 0;
+      if (argc > 4) {
+        interval = std::atol(argv[4]);
+      }
+      if (interval == 0) {
+        interval = std::max(std::size_t{1}, static_cast<std::size_t>(std::sqrt(
+                                                instructions.size())));
+      }
+
+      try {
+        History history(graph, instructions, part, interval);
+        std::cout << "Stored " << history.numSnapshots() << " snapshots"
+                  << std::endl;
+
+        // queries : <num applied instructions> or
+        //           <num applied instructions>:<stack id>
+        for (int i = 5; i < argc; ++i) {
+          const std::string query = argv[i];
+          const std::size_t separator = query.find(':');
+          const std::size_t num_applied =
+              std::stoul(query.substr(0, separator));
+          const int root_id = (separator == std::string::npos)
+                                  ? 0
+                                  : std::stoi(query.substr(separator + 1));
+
+          if (num_applied > instructions.size() || root_id < 0 ||
+              static_cast<std::size_t>(root_id) >= graph.size()) {
+            std::cout << "Invalid query: " << query << std::endl;
+            continue;
+          }
+
+          std::cout << "After " << num_applied << " instructions:"
+                    << std::endl;
+          history.at(num_applied).print(root_id);
+        }
+      } catch (const std::exception& error) {
+        std::cout << error.what() << std::endl;
+        return 1;
+      }
+      return 0;
+    }
+
+    try {
+      std::cout << traceRoots(graph, instructions, part) << std::endl;
+    } catch (const std::runtime_error& error) {
+      std::cout << error.what() << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  if (method == Method::OPTIMIZE) {
+    const std::size_t num_parsed = instructions.size();
+    instructions = optimizeInstructions(instructions, part);
+    std::cout << "Removed " << num_parsed - instructions.size() << " of "
+              << num_parsed << " instructions" << std::endl;
+  }
+
   switch (part) {
     case Part::FIRST: {
-      MoveInstruction instruction;
-      while (parseInstruction(ifile, instruction)) {
+      for (const MoveInstruction& instruction : instructions) {
         graph.moveIndividual(instruction);
       }
       graph.printRoots();
     } break;
     case Part::SECOND: {
-      MoveInstruction instruction;
-      while (parseInstruction(ifile, instruction)) {
+      for (const MoveInstruction& instruction : instructions) {
         graph.moveGrouped(instruction);
       }
       graph.printRoots();
@@ -114,147 +299,491 @@ int main(int argc, char** argv) {
 
 namespace {
 
-Graph::Graph(std::size_t num_nodes) {
-  roots_.resize(num_nodes + 1);
-  ends_.resize(num_nodes + 1);
-}
+Graph::Graph(std::size_t num_nodes) { stacks_.resize(num_nodes + 1); }
 
 void Graph::pushNode(const int root_id, const char c) {
-  Node*& root_end = ends_[root_id];
+  stacks_[root_id].push_back(c);
+}
 
-  if (root_end == nullptr) {
-    // first node of that stack of crates
-    roots_[root_id] = std::make_unique<Node>(c);
-    root_end = roots_[root_id].get();
-  } else {
-    root_end->next = std::make_unique<Node>(c);
-    root_end = root_end->next.get();
+void Graph::finalize() {
+  for (auto& stack : stacks_) {
+    std::reverse(stack.begin(), stack.end());
   }
 }
 
-void Graph::moveIndividual(const MoveInstruction& instruction) {
-  // move one crate at a time
-  for (int i = 0; i < instruction.num_crates; ++i) {
-    if (roots_[instruction.from] == nullptr) {
-      throw std::runtime_error("Stack empty");
-    }
+void moveCratesIndividual(std::vector<char>& from, std::vector<char>& to,
+                          int num_crates) {
+  if (from.size() < static_cast<std::size_t>(num_crates)) {
+    throw std::runtime_error("Stack empty");
+  }
 
-    Node* crate = roots_[instruction.from].get();
+  // moving crates onto the same stack does not change it
+  if (&from == &to) {
+    return;
+  }
 
-    // place crate on top of target stack
-    // original target stack root is now pointing to new origin root
-    crate->next.swap(roots_[instruction.to]);
+  // moving one crate at a time reverses the order of the moved crates
+  to.insert(to.end(), from.rbegin(), from.rbegin() + num_crates);
+  from.resize(from.size() - num_crates);
+}
 
-    // origin root picks up temporary value from target root
-    // and provides correct target root (which used to be origin root)
-    roots_[instruction.from].swap(roots_[instruction.to]);
+void moveCratesGrouped(std::vector<char>& from, std::vector<char>& to,
+                       int num_crates) {
+  if (from.size() < static_cast<std::size_t>(num_crates)) {
+    throw std::runtime_error("Unexpectedly reached bottom of stack");
+  }
 
-    // The last step could maybe be optimized by swapping the meaning of
-    // "to" and "from" in each loop, but unclear which one is really faster
+  // moving crates onto the same stack does not change it
+  if (&from == &to) {
+    return;
   }
+
+  // order of moved crates is kept
+  to.insert(to.end(), from.end() - num_crates, from.end());
+  from.resize(from.size() - num_crates);
+}
+
+void Graph::moveIndividual(const MoveInstruction& instruction) {
+  moveCratesIndividual(stacks_[instruction.from], stacks_[instruction.to],
+                       instruction.num_crates);
 }
 
 void Graph::moveGrouped(const MoveInstruction& instruction) {
-  Node* last_to_move = roots_[instruction.from].get();
+  moveCratesGrouped(stacks_[instruction.from], stacks_[instruction.to],
+                    instruction.num_crates);
+}
 
-  // find last crate to be moved
-  for (int i = 0; i < instruction.num_crates - 1; ++i) {
-    if (last_to_move->next != nullptr) {
-      last_to_move = last_to_move->next.get();
+void Graph::print() const {
+  for (int i = 0; i < stacks_.size(); ++i) {
+    if (stacks_[i].empty()) {
+      std::cout << i << ": empty" << std::endl;
     } else {
-      throw std::runtime_error("Unexpectedly reached bottom of stack");
+      // top to bottom
+      std::cout << i << ": "
+                << std::string(stacks_[i].crbegin(), stacks_[i].crend())
+                << std::endl;
     }
   }
+}
 
-  // place last node on top of target stack
-  // original target stack root is now pointing to new origin root
-  last_to_move->next.swap(roots_[instruction.to]);
+void Graph::printRoots() const {
+  for (const auto& stack : stacks_) {
+    std::cout << static_cast<char>(stack.empty() ? '*' : stack.back());
+  }
+  std::cout << std::endl;
+}
+
+bool Graph::empty() const { return (stacks_.size() == 0); }
+
+std::size_t Graph::size() const { return stacks_.size(); }
 
-  // origin root picks up temporary value from target root
-  // and provides correct target root (which used to be origin root)
-  roots_[instruction.from].swap(roots_[instruction.to]);
+std::size_t Graph::height(const int root_id) const {
+  return stacks_[root_id].size();
 }
 
-void Graph::print() const {
-  for (int i = 0; i < roots_.size(); ++i) {
-    if (roots_[i] == nullptr) {
-      std::cout << i << ": empty" << std::endl;
+const std::vector<char>& Graph::stack(const int root_id) const {
+  return stacks_[root_id];
+}
+
+char Graph::crate(const int root_id, const std::size_t depth) const {
+  const std::vector<char>& stack = stacks_[root_id];
+  return stack[stack.size() - 1 - depth];
+}
+
+std::vector<char> readFile(std::ifstream& ifile) {
+  ifile.seekg(0, std::ios::end);
+  std::vector<char> buffer(ifile.tellg());
+  ifile.seekg(0);
+  ifile.read(buffer.data(), buffer.size());
+  return buffer;
+}
+
+Graph readGraph(const std::vector<char>& buffer, std::size_t& pos) {
+  // format is
+  //     [X]     [X]
+  // [X] [X] ... [X]
+  //  1   2  ...  N
+  // lines have whitespace if no crates are present, labels may be wider than
+  // one column
+  struct Line {
+    std::size_t begin;
+    std::size_t end;
+  };
+  std::vector<Line> crate_lines;
+  Line label_line{0, 0};
+  bool reached_labels = false;
+
+  while (pos < buffer.size() && !reached_labels) {
+    std::size_t end = pos;
+    while (end < buffer.size() && buffer[end] != '\n') ++end;
+
+    std::size_t first = pos;
+    while (first < end &&
+           std::isspace(static_cast<unsigned char>(buffer[first]))) {
+      ++first;
+    }
+    if (first < end &&
+        std::isdigit(static_cast<unsigned char>(buffer[first]))) {
+      label_line = {pos, end};
+      reached_labels = true;
     } else {
-      std::cout << i << ": ";
-      Node* node = roots_[i].get();
-      while (node != nullptr) {
-        std::cout << char(node->name);
-        node = node->next.get();
+      crate_lines.push_back({pos, end});
+    }
+    pos = std::min(end + 1, buffer.size());
+  }
+
+  if (!reached_labels) {
+    std::cout << "Missing stack labels" << std::endl;
+    return Graph{0};
+  }
+
+  // skip empty line after stack description
+  while (pos < buffer.size() &&
+         (buffer[pos] == '\r' || buffer[pos] == '\n')) {
+    ++pos;
+  }
+
+  // labels with their center column (doubled to stay integral)
+  struct Label {
+    int id;
+    std::size_t center2;
+  };
+  std::vector<Label> labels;
+  int num_stacks = 0;
+  for (std::size_t i = label_line.begin; i < label_line.end;) {
+    if (!std::isdigit(static_cast<unsigned char>(buffer[i]))) {
+      ++i;
+      continue;
+    }
+    const std::size_t begin = i;
+    int id = 0;
+    while (i < label_line.end &&
+           std::isdigit(static_cast<unsigned char>(buffer[i]))) {
+      id = 10 * id + (buffer[i++] - '0');
+    }
+    labels.push_back(
+        {id, (begin - label_line.begin) + (i - 1 - label_line.begin)});
+    num_stacks = std::max(num_stacks, id);
+  }
+
+  // stack of every column, the label with the closest center
+  std::size_t max_width = label_line.end - label_line.begin;
+  for (const Line& line : crate_lines) {
+    max_width = std::max(max_width, line.end - line.begin);
+  }
+  std::vector<int> column_stacks(max_width);
+  std::size_t label_idx = 0;
+  for (std::size_t column = 0; column < max_width; ++column) {
+    while (label_idx + 1 < labels.size() &&
+           labels[label_idx + 1].center2 + labels[label_idx].center2 <=
+               4 * column) {
+      ++label_idx;
+    }
+    column_stacks[column] = labels[label_idx].id;
+  }
+
+  Graph graph(num_stacks);
+  for (const Line& line : crate_lines) {
+    for (std::size_t i = line.begin; i + 1 < line.end; ++i) {
+      if (buffer[i] != '[') {
+        continue;
+      }
+
+      const char c = buffer[i + 1];
+      if (std::isupper(static_cast<unsigned char>(c))) {
+        graph.pushNode(column_stacks[i + 1 - line.begin], c);
+      } else {
+        std::cout << "Unexpected input: " << c << std::endl;
       }
-      std::cout << std::endl;
     }
   }
+
+  graph.finalize();
+  return graph;
 }
 
-void Graph::printRoots() const {
-  for (const auto& up : roots_) {
-    std::cout << static_cast<char>(up == nullptr ? '*' : up->name);
+std::vector<MoveInstruction> parseInstructions(const std::vector<char>& buffer,
+                                               std::size_t pos) {
+  // format of line is always
+  // move X from A to B
+  // where X, A, B are positive integers, so words can be skipped until the next
+  // digit
+  const char* c = buffer.data() + pos;
+  const char* const end = buffer.data() + buffer.size();
+
+  auto scan_number = [end](const char*& c, int& value) {
+    while (c != end && static_cast<unsigned char>(*c - '0') > 9) ++c;
+    if (c == end) {
+      return false;
+    }
+    value = 0;
+    while (c != end && static_cast<unsigned char>(*c - '0') <= 9) {
+      value = 10 * value + (*c++ - '0');
+    }
+    return true;
+  };
+
+  // one instruction per line, last line might not contain eol
+  std::vector<MoveInstruction> instructions;
+  instructions.reserve(std::count(c, end, '\n') + 1);
+
+  MoveInstruction instruction;
+  while (scan_number(c, instruction.num_crates) &&
+         scan_number(c, instruction.from) && scan_number(c, instruction.to)) {
+    instructions.push_back(instruction);
   }
-  std::cout << std::endl;
+  return instructions;
 }
 
-bool Graph::empty() const { return (roots_.size() == 0); }
+std::vector<MoveInstruction> optimizeInstructions(
+    const std::vector<MoveInstruction>& instructions, Part part) {
+  // Combine two consecutive moves into one, returns false if they cannot be
+  // combined. A combined move without crates means that the moves cancel.
+  auto combine = [part](const MoveInstruction& first,
+                        const MoveInstruction& second,
+                        MoveInstruction& combined) {
+    const bool same_route =
+        (first.from == second.from && first.to == second.to);
+    const bool reverse_route =
+        (first.from == second.to && first.to == second.from);
+
+    // moving the same crates back restores both stacks in either part
+    if (reverse_route && first.num_crates == second.num_crates) {
+      combined = {first.from, first.to, 0};
+      return true;
+    }
 
-Graph readGraph(std::ifstream& ifile) {
-  // initial lines have whitespace if no elements are present
-  // characters are at every fourth plane
-  std::string line;
-  bool reached_actions = false;
+    switch (part) {
+      case Part::FIRST:
+        // single crate moves, only the net number of crates moved between two
+        // stacks matters
+        if (same_route) {
+          combined = {first.from, first.to,
+                      first.num_crates + second.num_crates};
+          return true;
+        } else if (reverse_route) {
+          const MoveInstruction& larger =
+              (first.num_crates > second.num_crates) ? first : second;
+          const MoveInstruction& smaller =
+              (first.num_crates > second.num_crates) ? second : first;
+          combined = {larger.from, larger.to,
+                      larger.num_crates - smaller.num_crates};
+          return true;
+        }
+        break;
+      case Part::SECOND:
+        // groups keep their order, so only a group moved on as a whole can
+        // skip the stack in between. Consecutive same route moves put the
+        // second group on top of the first one and can not be merged.
+        if (first.to == second.from && first.num_crates == second.num_crates) {
+          combined = {first.from, second.to, first.num_crates};
+          return true;
+        }
+        break;
+    }
+    return false;
+  };
 
-  if (!std::getline(ifile, line)) {
-    std::cout << "File stream was empty" << std::endl;
-    return Graph{0};
+  // reduced program is used as a stack, so that a combined move can combine
+  // with the move before it again
+  std::vector<MoveInstruction> reduced;
+  reduced.reserve(instructions.size());
+  for (MoveInstruction current : instructions) {
+    while (current.num_crates > 0 && current.from != current.to) {
+      MoveInstruction combined;
+      if (reduced.empty() || !combine(reduced.back(), current, combined)) {
+        reduced.push_back(current);
+        break;
+      }
+      reduced.pop_back();
+      current = combined;
+    }
   }
+  return reduced;
+}
 
-  // format is [X] [X]     [X] ... [X]
-  std::size_t num_stacks = (line.size() + 1) / 4;
-  Graph graph(num_stacks);
+std::string traceRoots(const Graph& graph,
+                       const std::vector<MoveInstruction>& instructions,
+                       Part part) {
+  // final heights, to know which stacks end up empty
+  std::vector<std::size_t> heights(graph.size());
+  for (std::size_t id = 0; id < graph.size(); ++id) {
+    heights[id] = graph.height(id);
+  }
+  for (const MoveInstruction& instruction : instructions) {
+    if (heights[instruction.from] <
+        static_cast<std::size_t>(instruction.num_crates)) {
+      throw std::runtime_error("Stack empty");
+    }
+    heights[instruction.from] -= instruction.num_crates;
+    heights[instruction.to] += instruction.num_crates;
+  }
 
-  do {
-    char* c = &line[1];
-    for (int stack_idx = 1; stack_idx <= num_stacks; ++stack_idx, c += 4) {
-      if (*c != ' ') {
-        if (std::isupper(static_cast<unsigned char>(*c))) {
-          graph.pushNode(stack_idx, *c);
-        } else if (std::isdigit(static_cast<unsigned char>(*c))) {
-          // reached final lines with column digits
-          reached_actions = true;
-          break;
+  // position of each final top crate, as stack and depth below the top
+  struct Position {
+    int stack;
+    std::size_t depth;
+  };
+  std::vector<Position> positions;
+  std::vector<int> traced_stacks;
+  for (std::size_t id = 0; id < graph.size(); ++id) {
+    if (heights[id] > 0) {
+      positions.push_back({static_cast<int>(id), 0});
+      traced_stacks.push_back(id);
+    }
+  }
+
+  for (auto it = instructions.crbegin(); it != instructions.crend(); ++it) {
+    const MoveInstruction& instruction = *it;
+    if (instruction.from == instruction.to) {
+      continue;
+    }
+
+    const std::size_t num_crates = instruction.num_crates;
+    for (Position& position : positions) {
+      if (position.stack == instruction.to) {
+        if (position.depth < num_crates) {
+          // crate was moved by this instruction, moving one at a time
+          // reverses the order
+          position.stack = instruction.from;
+          if (part == Part::FIRST) {
+            position.depth = num_crates - 1 - position.depth;
+          }
         } else {
-          std::cout << "Unexpected input: " << char(*c) << std::endl;
+          position.depth -= num_crates;
         }
+      } else if (position.stack == instruction.from) {
+        // moved crates were on top of it
+        position.depth += num_crates;
       }
     }
-  } while (!reached_actions && std::getline(ifile, line));
+  }
 
-  // skip empty line after stack description
-  ifile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  std::string roots(graph.size(), '*');
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    roots[traced_stacks[i]] =
+        graph.crate(positions[i].stack, positions[i].depth);
+  }
+  return roots;
+}
 
-  return graph;
+SharedStacks::SharedStacks(const Graph& graph) : stacks_(graph.size()) {
+  for (std::size_t id = 0; id < graph.size(); ++id) {
+    moved_ = graph.stack(id);
+    push(stacks_[id]);
+  }
 }
 
-bool parseInstruction(std::ifstream& ifile, MoveInstruction& instruction) {
-  // format of line is always
-  // move X from A to B
-  // where X, A, B are positive integers
-  ifile.ignore(5);  // skip "move"
-  ifile >> instruction.num_crates;
-  ifile.ignore(6);  // skip " from "
-  ifile >> instruction.from;
-  ifile.ignore(4);  // skip " to "
-  ifile >> instruction.to;
+void SharedStacks::apply(const MoveInstruction& instruction, Part part) {
+  Stack& from = stacks_[instruction.from];
+  Stack& to = stacks_[instruction.to];
+  const std::size_t num_crates = instruction.num_crates;
+
+  if (from.height < num_crates) {
+    throw std::runtime_error((part == Part::FIRST)
+                                 ? "Stack empty"
+                                 : "Unexpectedly reached bottom of stack");
+  }
+
+  // moving crates onto the same stack does not change it
+  if (&from == &to) {
+    return;
+  }
+
+  readTop(from, num_crates);
+  if (part == Part::FIRST) {
+    // moving one crate at a time reverses the order of the moved crates
+    std::reverse(moved_.begin(), moved_.end());
+  }
+  pop(from, num_crates);
+  push(to);
+}
+
+void SharedStacks::print(const int root_id) const {
+  std::string crates;
+  for (std::size_t i = 1; i < stacks_.size(); ++i) {
+    if (root_id != 0 && i != static_cast<std::size_t>(root_id)) {
+      continue;
+    }
 
-  // last line does not contain eol and would fail
-  bool success = !ifile.fail();
+    const Stack& stack = stacks_[i];
+    if (stack.height == 0) {
+      std::cout << i << ": empty" << std::endl;
+    } else {
+      // top to bottom
+      crates.clear();
+      for (std::size_t depth = 0; depth < stack.height; ++depth) {
+        const std::size_t idx = stack.height - 1 - depth;
+        crates.push_back((*stack.chunks[idx / CHUNK_SIZE])[idx % CHUNK_SIZE]);
+      }
+      std::cout << i << ": " << crates << std::endl;
+    }
+  }
+}
 
-  ifile.ignore(1);  // skip eol
+void SharedStacks::readTop(const Stack& stack, std::size_t num_crates) {
+  moved_.clear();
+  for (std::size_t idx = stack.height - num_crates; idx < stack.height;) {
+    const Chunk& chunk = *stack.chunks[idx / CHUNK_SIZE];
+    const std::size_t begin = idx % CHUNK_SIZE;
+    const std::size_t end = std::min(CHUNK_SIZE, begin + (stack.height - idx));
+    moved_.insert(moved_.end(), chunk.begin() + begin, chunk.begin() + end);
+    idx += end - begin;
+  }
+}
 
-  return success;
+void SharedStacks::pop(Stack& stack, std::size_t num_crates) {
+  // crates above the new top in the last chunk are overwritten by the next push
+  stack.height -= num_crates;
+  stack.chunks.resize((stack.height + CHUNK_SIZE - 1) / CHUNK_SIZE);
+}
+
+void SharedStacks::push(Stack& stack) {
+  for (std::size_t i = 0; i < moved_.size();) {
+    const std::size_t chunk_idx = stack.height / CHUNK_SIZE;
+    const std::size_t begin = stack.height % CHUNK_SIZE;
+    if (chunk_idx == stack.chunks.size()) {
+      stack.chunks.push_back(std::make_shared<Chunk>());
+    } else if (stack.chunks[chunk_idx].use_count() > 1) {
+      // chunk is still part of a snapshot
+      stack.chunks[chunk_idx] =
+          std::make_shared<Chunk>(*stack.chunks[chunk_idx]);
+    }
+
+    const std::size_t count = std::min(CHUNK_SIZE - begin, moved_.size() - i);
+    std::copy_n(moved_.begin() + i, count,
+                stack.chunks[chunk_idx]->begin() + begin);
+    stack.height += count;
+    i += count;
+  }
+}
+
+History::History(const Graph& graph,
+                 const std::vector<MoveInstruction>& instructions, Part part,
+                 std::size_t interval)
+    : instructions_{instructions}, part_{part}, interval_{interval} {
+  SharedStacks current(graph);
+  snapshots_.reserve(instructions.size() / interval + 1);
+  snapshots_.push_back(current);
+
+  for (std::size_t i = 0; i < instructions.size(); ++i) {
+    current.apply(instructions[i], part);
+    if ((i + 1) % interval == 0) {
+      snapshots_.push_back(current);
+    }
+  }
+}
+
+SharedStacks History::at(std::size_t num_applied) const {
+  const std::size_t snapshot_idx = num_applied / interval_;
+
+  // copy of snapshot shares all chunks, they are copied once written
+  SharedStacks stacks = snapshots_[snapshot_idx];
+  for (std::size_t i = snapshot_idx * interval_; i < num_applied; ++i) {
+    stacks.apply(instructions_[i], part_);
+  }
+  return stacks;
 }
 
+std::size_t History::numSnapshots() const { return snapshots_.size(); }
 }  // namespace
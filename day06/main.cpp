@@ -1,13 +1,43 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <string>
+#include <thread>
 #include <utility>
+#include <variant>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace {
 enum class Part { FIRST = 0, SECOND };
 
+enum class Method {
+  SCAN = 0,  // compare each new character with the whole window
+  COUNT,     // keep a count per character value
+  LENGTHS,   // search for several marker lengths in one pass
+  VECTOR,    // compare many window positions at once on the memory-mapped file
+  PARALLEL,  // search chunks of the memory-mapped file in parallel
+  REPORT     // write all unique windows instead of stopping at the first one
+};
+
+enum class Report {
+  WINDOWS = 0,  // every unique window
+  RUNS          // maximal ranges in which every window is unique
+};
+
 // For high values of SIZE, having a set with a insert lookup probably more efficient
 template <std::size_t SIZE>
 struct UniqueBuffer {
@@ -46,6 +76,180 @@ struct UniqueBuffer {
   // Note : N identical characters == N-1 duplicates
   std::size_t duplicate_counter_ = BUFFER_SIZE_ - 1;
 };
+
+// Same as UniqueBuffer, but the number of occurrences of every character value in the
+// window is counted, so that each push is O(1) for any window size
+class CountingUniqueBuffer {
+ public:
+  CountingUniqueBuffer(std::size_t size)
+      : buffer_(size, 0), duplicate_counter_{size - 1} {
+    counts_[0] = size;  // zero-initialized like UniqueBuffer
+  }
+
+  void push(char c) {
+    const unsigned char old_char = std::exchange(buffer_[idx_], c);
+    if (--counts_[old_char] > 0) {
+      --duplicate_counter_;
+    }
+    if (counts_[static_cast<unsigned char>(c)]++ > 0) {
+      ++duplicate_counter_;
+    }
+
+    if (++idx_ == buffer_.size()) {
+      idx_ = 0;
+    }
+  }
+
+  bool isUnique() const { return (duplicate_counter_ == 0); }
+
+ private:
+  std::size_t idx_ = 0;
+  std::vector<char> buffer_;
+  std::array<std::size_t, 256> counts_ = {};
+
+  // Note : N identical characters == N-1 duplicates
+  std::size_t duplicate_counter_;
+};
+
+// Position of the last character of the first window of msg_len unique characters,
+// 0 if there is none
+template <typename UniqueBufferT>
+std::size_t findStart(std::istream& istream, UniqueBufferT& buffer, std::size_t msg_len) {
+  std::size_t pos = 0;
+  char c;
+  while (istream.get(c)) {
+    ++pos;
+    buffer.push(c);
+    if (buffer.isUnique() && pos >= msg_len) {
+      return pos;
+    }
+  }
+  return 0;
+}
+
+// Same as above for the next size characters of a buffer, which start after offset
+// characters of the input
+template <typename UniqueBufferT>
+std::size_t findStart(const char* data, std::size_t size, std::size_t offset, UniqueBufferT& buffer,
+                      std::size_t msg_len) {
+  for (std::size_t i = 0; i < size; ++i) {
+    buffer.push(data[i]);
+    if (buffer.isUnique() && offset + i + 1 >= msg_len) {
+      return offset + i + 1;
+    }
+  }
+  return 0;
+}
+
+// Search for the first marker of one length, common lengths use a fixed size buffer
+struct MarkerSearch {
+  using Buffer = std::variant<UniqueBuffer<4>, UniqueBuffer<8>, UniqueBuffer<14>, UniqueBuffer<16>,
+                              CountingUniqueBuffer>;
+
+  MarkerSearch(std::size_t length) : msg_len{length}, buffer{makeBuffer(length)} {}
+
+  static Buffer makeBuffer(std::size_t length) {
+    switch (length) {
+      case 4:
+        return UniqueBuffer<4>{};
+      case 8:
+        return UniqueBuffer<8>{};
+      case 14:
+        return UniqueBuffer<14>{};
+      case 16:
+        return UniqueBuffer<16>{};
+      default:
+        return CountingUniqueBuffer(length);
+    }
+  }
+
+  std::size_t msg_len;
+  Buffer buffer;
+  std::size_t pos = 0;  // 0 until found
+};
+
+// Find the first marker of every length in a single pass over the input. The input is read
+// in chunks, so that the buffer type of each search is only dispatched once per chunk.
+void findStarts(std::istream& istream, std::vector<MarkerSearch>& searches) {
+  static constexpr std::size_t CHUNK_SIZE = 1 << 16;
+  std::vector<char> chunk(CHUNK_SIZE);
+  std::size_t offset = 0;
+  std::size_t num_open = searches.size();
+
+  while (num_open > 0 && istream) {
+    istream.read(chunk.data(), chunk.size());
+    const std::size_t size = istream.gcount();
+
+    for (MarkerSearch& search : searches) {
+      if (search.pos > 0) {
+        continue;
+      }
+
+      search.pos = std::visit(
+          [&](auto& buffer) {
+            return findStart(chunk.data(), size, offset, buffer, search.msg_len);
+          },
+          search.buffer);
+      if (search.pos > 0) {
+        --num_open;
+      }
+    }
+    offset += size;
+  }
+}
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+ public:
+  MappedFile(const std::string& filename);
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool good() const { return good_; }
+  const char* data() const { return data_; }
+  std::size_t size() const { return size_; }
+
+ private:
+  bool good_ = false;
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// Windows longer than this are searched with CountingUniqueBuffer, so that all distances
+// and sums below fit into a byte
+constexpr std::size_t MAX_VECTOR_MSG_LEN = 64;
+
+// Same result as findStart with any buffer. The distance of every character to the previous
+// equal character is computed for many positions at once, a window is unique if no character
+// has an equal one within the window before it.
+std::size_t findStartVectorized(const char* data, std::size_t size, std::size_t msg_len);
+
+// Same result as findStart, window ends are split into one chunk per thread. Chunks include
+// the msg_len - 1 characters before them, and are searched with the buffer of MarkerSearch.
+// Threads stop once an earlier chunk found a marker.
+std::size_t parallelFindStart(const char* data, std::size_t size, std::size_t msg_len,
+                              std::size_t num_threads);
+
+// Writes ranges of characters (first and last character, starting at 1) either as CSV lines
+// or as binary records of two native uint64_t
+class RangeWriter {
+ public:
+  RangeWriter(std::ostream& ostream, bool binary);
+
+  void write(std::size_t first, std::size_t last);
+
+  std::size_t numRanges() const { return num_ranges_; }
+
+ private:
+  std::ostream& ostream_;
+  bool binary_;
+  std::size_t num_ranges_ = 0;
+};
+
+// Write all unique windows of msg_len characters, or runs of them, while the input is read in
+// chunks. Memory does not depend on the size of the input.
+void reportMarkers(std::istream& istream, std::size_t msg_len, Report report, RangeWriter& writer);
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -67,6 +271,78 @@ int main(int argc, char** argv) {
     }
   }
 
+  Method method = Method::SCAN;
+  if (argc > 3) {
+    unsigned int method_value = std::atol(argv[3]);
+    if (method_value == 0) {
+      method = Method::SCAN;
+    } else if (method_value == 1) {
+      method = Method::COUNT;
+    } else if (method_value == 2) {
+      method = Method::LENGTHS;
+    } else if (method_value == 3) {
+      method = Method::VECTOR;
+    } else if (method_value == 4) {
+      method = Method::PARALLEL;
+    } else if (method_value == 5) {
+      method = Method::REPORT;
+    } else {
+      std::cout << "Invalid method: " << method_value << std::endl;
+      return 1;
+    }
+  }
+
+  // optional: marker length, overrides the length of the part
+  // (all further arguments are marker lengths for method 2, default are both parts)
+  std::size_t msg_len = (part == Part::FIRST) ? 4 : 14;
+  std::vector<MarkerSearch> searches;
+  if (method == Method::LENGTHS) {
+    for (int i = 4; i < argc; ++i) {
+      const std::size_t length = std::atol(argv[i]);
+      if (length == 0) {
+        std::cout << "Invalid marker length: " << argv[i] << std::endl;
+        return 1;
+      }
+      searches.emplace_back(length);
+    }
+  } else if (argc > 4) {
+    msg_len = std::atol(argv[4]);
+    if (msg_len == 0) {
+      std::cout << "Invalid marker length: " << argv[4] << std::endl;
+      return 1;
+    }
+  }
+
+  // optional: number of threads for method 4, 0 for one per hardware thread
+  std::size_t num_threads = 0;
+  if (argc > 5 && method == Method::PARALLEL) {
+    num_threads = std::atol(argv[5]);
+  }
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // optional: report type for method 5 and output file, CSV on stdout by default
+  // (binary records if the file name ends with .bin)
+  Report report = Report::WINDOWS;
+  std::string output_filename;
+  if (method == Method::REPORT) {
+    if (argc > 5) {
+      unsigned int report_value = std::atol(argv[5]);
+      if (report_value == 0) {
+        report = Report::WINDOWS;
+      } else if (report_value == 1) {
+        report = Report::RUNS;
+      } else {
+        std::cout << "Invalid report type: " << report_value << std::endl;
+        return 1;
+      }
+    }
+    if (argc > 6) {
+      output_filename = argv[6];
+    }
+  }
+
   std::string filename = argv[1];
   std::ifstream ifile(argv[1]);
 
@@ -75,50 +351,373 @@ int main(int argc, char** argv) {
     return 1;
   }
 
-  switch (part) {
-    case Part::FIRST: {
-      static constexpr std::size_t MSG_LEN = 4;
-      std::size_t pos = 0;
-      UniqueBuffer<MSG_LEN> buffer;
-
-      bool start_found = false;
-      char c;
-      while (!start_found && ifile.get(c)) {
-        ++pos;
-        buffer.push(c);
-        if (buffer.isUnique() && pos >= MSG_LEN) {
-          start_found = true;
-        }
+  if (method == Method::REPORT) {
+    if (output_filename.empty()) {
+      RangeWriter writer(std::cout, false);
+      reportMarkers(ifile, msg_len, report, writer);
+      return 0;
+    }
+
+    const bool binary = output_filename.ends_with(".bin");
+    std::ofstream ofile(output_filename, binary ? std::ios::binary : std::ios::out);
+    if (!ofile.good()) {
+      std::cout << "Could not open " << output_filename << std::endl;
+      return 1;
+    }
+
+    RangeWriter writer(ofile, binary);
+    reportMarkers(ifile, msg_len, report, writer);
+    std::cout << "Wrote " << writer.numRanges()
+              << ((report == Report::WINDOWS) ? " windows" : " runs") << " to "
+              << output_filename << std::endl;
+    return 0;
+  }
+
+  if (method == Method::LENGTHS) {
+    if (searches.empty()) {
+      searches.emplace_back(4);
+      searches.emplace_back(14);
+    }
+
+    findStarts(ifile, searches);
+    for (const MarkerSearch& search : searches) {
+      if (search.pos > 0) {
+        std::cout << "Marker of length " << search.msg_len << " ended at character " << search.pos
+                  << std::endl;
+      } else {
+        std::cout << "No marker of length " << search.msg_len << " found" << std::endl;
       }
+    }
+    return 0;
+  }
 
-      if (start_found) {
-        std::cout << "Start sequence ended at character " << pos << std::endl;
+  std::size_t pos = 0;
+  switch (method) {
+    case Method::SCAN:
+      if (msg_len == 4) {
+        UniqueBuffer<4> buffer;
+        pos = findStart(ifile, buffer, msg_len);
+      } else if (msg_len == 14) {
+        UniqueBuffer<14> buffer;
+        pos = findStart(ifile, buffer, msg_len);
       } else {
-        std::cout << "No start sequence found" << std::endl;
+        std::cout << "Marker length " << msg_len << " requires method 1" << std::endl;
+        return 1;
       }
+      break;
+    case Method::COUNT: {
+      CountingUniqueBuffer buffer(msg_len);
+      pos = findStart(ifile, buffer, msg_len);
     } break;
-    case Part::SECOND: {
-      static constexpr std::size_t MSG_LEN = 14;
-      std::size_t pos = 0;
-      UniqueBuffer<MSG_LEN> buffer;
-
-      bool start_found = false;
-      char c;
-      while (!start_found && ifile.get(c)) {
-        ++pos;
-        buffer.push(c);
-        if (buffer.isUnique() && pos >= MSG_LEN) {
-          start_found = true;
-        }
+    case Method::LENGTHS:  // handled above
+    case Method::REPORT:
+      break;
+    case Method::VECTOR: {
+      const MappedFile file(filename);
+      if (!file.good()) {
+        std::cout << "Could not map " << filename << std::endl;
+        return 1;
       }
+      pos = findStartVectorized(file.data(), file.size(), msg_len);
+    } break;
+    case Method::PARALLEL: {
+      const MappedFile file(filename);
+      if (!file.good()) {
+        std::cout << "Could not map " << filename << std::endl;
+        return 1;
+      }
+      pos = parallelFindStart(file.data(), file.size(), msg_len, num_threads);
+    } break;
+  }
 
-      if (start_found) {
+  switch (part) {
+    case Part::FIRST:
+      if (pos > 0) {
+        std::cout << "Start sequence ended at character " << pos << std::endl;
+      } else {
+        std::cout << "No start sequence found" << std::endl;
+      }
+      break;
+    case Part::SECOND:
+      if (pos > 0) {
         std::cout << "Start packet sequence ended at character " << pos << std::endl;
       } else {
         std::cout << "No packet start found" << std::endl;
       }
-    } break;
+      break;
   }
 
   return 0;
 }
+
+namespace {
+
+MappedFile::MappedFile(const std::string& filename) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == 0) {
+    size_ = file_stat.st_size;
+    if (size_ == 0) {
+      good_ = true;  // nothing to map
+    } else {
+      void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping != MAP_FAILED) {
+        madvise(mapping, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(mapping);
+        good_ = true;
+      }
+    }
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+// distances[j - begin] for every position j in [begin, end) : distance to the previous equal
+// character, msg_len if there is none within msg_len - 1 characters.
+// Note: begin >= msg_len - 1
+void computeDistances(const unsigned char* data, std::size_t begin, std::size_t end,
+                      std::size_t msg_len, unsigned char* distances) {
+  std::size_t j = begin;
+#if defined(__AVX2__)
+  const __m256i no_duplicate = _mm256_set1_epi8(msg_len);
+  const __m256i all_set = _mm256_set1_epi8(-1);
+  for (; j + 32 <= end; j += 32) {
+    const __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + j));
+    __m256i distance = no_duplicate;
+    for (std::size_t k = 1; k < msg_len; ++k) {
+      const __m256i previous = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + j - k));
+      const __m256i equal = _mm256_cmpeq_epi8(current, previous);
+      // k where equal, 0xFF otherwise
+      const __m256i candidate =
+          _mm256_or_si256(_mm256_andnot_si256(equal, all_set), _mm256_set1_epi8(k));
+      distance = _mm256_min_epu8(distance, candidate);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(distances + j - begin), distance);
+  }
+#elif defined(__SSE2__)
+  const __m128i no_duplicate = _mm_set1_epi8(msg_len);
+  const __m128i all_set = _mm_set1_epi8(-1);
+  for (; j + 16 <= end; j += 16) {
+    const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + j));
+    __m128i distance = no_duplicate;
+    for (std::size_t k = 1; k < msg_len; ++k) {
+      const __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + j - k));
+      const __m128i equal = _mm_cmpeq_epi8(current, previous);
+      // k where equal, 0xFF otherwise
+      const __m128i candidate = _mm_or_si128(_mm_andnot_si128(equal, all_set), _mm_set1_epi8(k));
+      distance = _mm_min_epu8(distance, candidate);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(distances + j - begin), distance);
+  }
+#endif
+  for (; j < end; ++j) {
+    std::size_t k = 1;
+    while (k < msg_len && data[j] != data[j - k]) ++k;
+    distances[j - begin] = k;
+  }
+}
+
+// Index of the first window end in [first, end) whose window is unique, end if there is none.
+// distances start at position first - (msg_len - 1). The window ending at p is unique if
+// distance(p - i) + i >= msg_len for all i < msg_len.
+std::size_t findUniqueWindow(const unsigned char* distances, std::size_t first, std::size_t end,
+                             std::size_t msg_len) {
+  const unsigned char* const last_distances = distances + msg_len - 1;  // of window ends
+  std::size_t p = first;
+#if defined(__AVX2__)
+  const __m256i min_sum = _mm256_set1_epi8(msg_len);
+  for (; p + 32 <= end; p += 32) {
+    __m256i unique = _mm256_set1_epi8(-1);
+    for (std::size_t i = 0; i < msg_len; ++i) {
+      const __m256i distance =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(last_distances + p - first - i));
+      const __m256i sum = _mm256_add_epi8(distance, _mm256_set1_epi8(i));
+      unique = _mm256_and_si256(unique, _mm256_cmpeq_epi8(_mm256_max_epu8(sum, min_sum), sum));
+    }
+
+    const uint32_t mask = _mm256_movemask_epi8(unique);
+    if (mask != 0) {
+      return p + std::countr_zero(mask);
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128i min_sum = _mm_set1_epi8(msg_len);
+  for (; p + 16 <= end; p += 16) {
+    __m128i unique = _mm_set1_epi8(-1);
+    for (std::size_t i = 0; i < msg_len; ++i) {
+      const __m128i distance =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(last_distances + p - first - i));
+      const __m128i sum = _mm_add_epi8(distance, _mm_set1_epi8(i));
+      unique = _mm_and_si128(unique, _mm_cmpeq_epi8(_mm_max_epu8(sum, min_sum), sum));
+    }
+
+    const uint32_t mask = _mm_movemask_epi8(unique);
+    if (mask != 0) {
+      return p + std::countr_zero(mask);
+    }
+  }
+#endif
+  for (; p < end; ++p) {
+    std::size_t i = 0;
+    while (i < msg_len && last_distances[p - first - i] + i >= msg_len) ++i;
+    if (i == msg_len) {
+      return p;
+    }
+  }
+  return end;
+}
+
+std::size_t findStartVectorized(const char* data, std::size_t size, std::size_t msg_len) {
+  if (msg_len > MAX_VECTOR_MSG_LEN) {
+    CountingUniqueBuffer buffer(msg_len);
+    return findStart(data, size, 0, buffer, msg_len);
+  }
+
+  // windows ending before the first 2 * msg_len - 2 characters compare characters before
+  // the start of the data
+  const std::size_t head = std::min(size, 2 * msg_len - 2);
+  CountingUniqueBuffer buffer(msg_len);
+  if (const std::size_t pos = findStart(data, head, 0, buffer, msg_len); pos > 0) {
+    return pos;
+  }
+
+  // blocks of window ends, the distances of a block include the msg_len - 1 positions before it
+  static constexpr std::size_t BLOCK_SIZE = 1 << 12;
+  std::vector<unsigned char> distances(BLOCK_SIZE + msg_len - 1);
+  const unsigned char* const bytes = reinterpret_cast<const unsigned char*>(data);
+  for (std::size_t block_begin = head; block_begin < size; block_begin += BLOCK_SIZE) {
+    const std::size_t block_end = std::min(size, block_begin + BLOCK_SIZE);
+    computeDistances(bytes, block_begin - (msg_len - 1), block_end, msg_len, distances.data());
+
+    const std::size_t p = findUniqueWindow(distances.data(), block_begin, block_end, msg_len);
+    if (p < block_end) {
+      return p + 1;
+    }
+  }
+  return 0;
+}
+
+std::size_t parallelFindStart(const char* data, std::size_t size, std::size_t msg_len,
+                              std::size_t num_threads) {
+  // small inputs are not worth a thread
+  static constexpr std::size_t MIN_CHUNK_SIZE = 1 << 16;
+  const std::size_t num_chunks =
+      std::max<std::size_t>(1, std::min(num_threads, size / MIN_CHUNK_SIZE));
+
+  // end of the earliest marker found so far
+  std::atomic<std::size_t> earliest{std::numeric_limits<std::size_t>::max()};
+
+  std::vector<std::thread> workers;
+  for (std::size_t i = 0; i < num_chunks; ++i) {
+    workers.emplace_back([&, i]() {
+      // window ends of the chunk are in [chunk_begin, chunk_end)
+      const std::size_t chunk_begin = i * (size / num_chunks);
+      const std::size_t chunk_end = (i + 1 == num_chunks) ? size : (i + 1) * (size / num_chunks);
+      const std::size_t data_begin = chunk_begin - std::min(chunk_begin, msg_len - 1);
+
+      MarkerSearch search(msg_len);
+      std::visit(
+          [&](auto& buffer) {
+            // check between blocks whether an earlier chunk was successful
+            static constexpr std::size_t BLOCK_SIZE = 1 << 14;
+            for (std::size_t block_begin = data_begin; block_begin < chunk_end;
+                 block_begin += BLOCK_SIZE) {
+              if (earliest.load(std::memory_order_relaxed) <= chunk_begin) {
+                return;
+              }
+
+              const std::size_t block_size = std::min(BLOCK_SIZE, chunk_end - block_begin);
+              // positions relative to data_begin, the buffer does not contain earlier characters
+              search.pos = findStart(data + block_begin, block_size, block_begin - data_begin,
+                                     buffer, msg_len);
+              if (search.pos > 0) {
+                const std::size_t pos = data_begin + search.pos;
+                std::size_t current = earliest.load();
+                while (pos < current && !earliest.compare_exchange_weak(current, pos)) {
+                }
+                return;
+              }
+            }
+          },
+          search.buffer);
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  const std::size_t pos = earliest.load();
+  return (pos == std::numeric_limits<std::size_t>::max()) ? 0 : pos;
+}
+
+RangeWriter::RangeWriter(std::ostream& ostream, bool binary) : ostream_{ostream}, binary_{binary} {
+  if (!binary_) {
+    ostream_ << "first,last\n";
+  }
+}
+
+void RangeWriter::write(std::size_t first, std::size_t last) {
+  if (binary_) {
+    const uint64_t record[2] = {first, last};
+    ostream_.write(reinterpret_cast<const char*>(record), sizeof(record));
+  } else {
+    ostream_ << first << ',' << last << '\n';
+  }
+  ++num_ranges_;
+}
+
+void reportMarkers(std::istream& istream, std::size_t msg_len, Report report, RangeWriter& writer) {
+  static constexpr std::size_t CHUNK_SIZE = 1 << 16;
+  std::vector<char> chunk(CHUNK_SIZE);
+  MarkerSearch search(msg_len);
+  std::size_t pos = 0;
+  std::size_t run_first = 0;  // 0 if not in a run of unique windows
+  std::size_t run_last = 0;
+
+  while (istream.read(chunk.data(), chunk.size()) || istream.gcount() > 0) {
+    const std::size_t size = istream.gcount();
+    std::visit(
+        [&](auto& buffer) {
+          for (std::size_t i = 0; i < size; ++i) {
+            ++pos;
+            buffer.push(chunk[i]);
+            const bool unique = buffer.isUnique() && pos >= msg_len;
+
+            switch (report) {
+              case Report::WINDOWS:
+                if (unique) {
+                  writer.write(pos - msg_len + 1, pos);
+                }
+                break;
+              case Report::RUNS:
+                if (unique) {
+                  if (run_first == 0) {
+                    run_first = pos - msg_len + 1;
+                  }
+                  run_last = pos;
+                } else if (run_first > 0) {
+                  writer.write(run_first, run_last);
+                  run_first = 0;
+                }
+                break;
+            }
+          }
+        },
+        search.buffer);
+  }
+
+  if (run_first > 0) {
+    writer.write(run_first, run_last);
+  }
+}
+}  // namespace
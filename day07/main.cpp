@@ -1,16 +1,28 @@
+#include <cctype>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 // TODO: Maybe this would be a challenge application for coroutines?
 // Could traverse the tree, co_await a next directory command etc
 namespace {
 enum class Part { FIRST = 0, SECOND };
 
+enum class Method {
+  TREE = 0,  // build the directory tree, then traverse it
+  STREAM,    // sizes of open directories only, each directory is sized when it is left
+  FLAT       // build a flat node table, then size all directories in one reverse pass
+};
+
+constexpr std::size_t TOTAL_DISK_SIZE = 70000000;
+constexpr std::size_t REQUIRED_SIZE = 30000000;
+
 struct Node {
   Node(Node* parent);
   Node(Node* parent, const std::string& name);
@@ -41,6 +53,57 @@ struct Node {
                                       std::size_t& current_min);
 };
 
+// Stores each distinct name once in a single character pool, names are referred to by id
+class NamePool {
+ public:
+  // return the id of name, adding it to the pool if it was not seen yet
+  std::uint32_t intern(std::string_view name);
+
+  std::string_view get(std::uint32_t id) const;
+
+  std::size_t size() const { return offsets_.size() - 1; }
+
+ private:
+  void grow();
+
+  std::string chars_;
+  std::vector<std::uint32_t> offsets_ = {0};  // name i is chars_[offsets_[i], offsets_[i+1])
+
+  // open addressing hash index, slot holds id + 1, 0 is empty
+  std::vector<std::uint32_t> slots_ = std::vector<std::uint32_t>(64, 0);
+};
+
+// Directory tree as a table of nodes, a node is referred to by its index.
+// Nodes are only appended, so a child always has a larger index than its parent
+// and all subtree sizes can be computed by one pass over the indices in reverse.
+// Names are only kept to tell directories apart.
+struct FlatTree {
+  static constexpr std::uint32_t ROOT = 0;
+
+  FlatTree();
+
+  // enter (and if needed create) new directory, ".." returns the parent
+  std::uint32_t visitChild(std::uint32_t node, const std::string& name);
+
+  // return total size of tree below each node
+  std::vector<std::size_t> getTotalSizes() const;
+
+  std::vector<std::uint32_t> parents;  // root is its own parent
+  std::vector<std::uint32_t> name_ids;
+  std::vector<std::size_t> local_sizes;
+
+  NamePool names;
+
+ private:
+  std::size_t childSlot(std::uint32_t node, std::uint32_t name_id) const;
+
+  void growChildren();
+
+  // open addressing hash index of (parent, name id) like NamePool, slot holds the index of
+  // the child node, 0 is empty (root is never a child)
+  std::vector<std::uint32_t> child_slots_ = std::vector<std::uint32_t>(64, 0);
+};
+
 // helpers to make input parsing more readable
 enum class Command { INVALID, LS, CD, CD_ROOT };
 
@@ -52,6 +115,22 @@ struct CliCommand {
 // we assume the input is valid
 void parse(std::ifstream& ifile, CliCommand& cli);
 
+// read the output of ls, returns the total size of listed files
+std::size_t readListing(std::ifstream& ifile);
+
+// Sum of all listed file sizes without following any directories, the input is rewound
+// afterwards so that it can be parsed again.
+// Note: requires a seekable file
+std::size_t readTotalSize(std::ifstream& ifile);
+
+// Parse the input with a stack of the sizes of all directories from the root to the current
+// one. When a directory is left, its total size is passed to emit(dir_size)
+// and added to its parent, the root is emitted last. Returns the total size.
+// Memory only depends on the depth of the tree.
+// Note: assumes that every directory is entered once, like a depth first traversal
+template <typename EmitFn>
+std::size_t streamDirectorySizes(std::ifstream& ifile, EmitFn emit);
+
 void print(const Node& node);
 
 void print(const Node& node, int level);
@@ -76,6 +155,21 @@ int main(int argc, char** argv) {
     }
   }
 
+  Method method = Method::TREE;
+  if (argc > 3) {
+    unsigned int method_value = std::atol(argv[3]);
+    if (method_value == 0) {
+      method = Method::TREE;
+    } else if (method_value == 1) {
+      method = Method::STREAM;
+    } else if (method_value == 2) {
+      method = Method::FLAT;
+    } else {
+      std::cout << "Invalid method: " << method_value << std::endl;
+      return 1;
+    }
+  }
+
   std::string filename = argv[1];
   std::ifstream ifile(argv[1]);
 
@@ -84,6 +178,105 @@ int main(int argc, char** argv) {
     return 1;
   }
 
+  if (method == Method::STREAM) {
+    switch (part) {
+      case Part::FIRST: {
+        std::size_t max_size = 100000;
+        std::size_t selected_sizes = 0;
+        streamDirectorySizes(ifile, [&](std::size_t dir_size) {
+          if (dir_size <= max_size) {
+            selected_sizes += dir_size;
+          }
+        });
+
+        std::cout << "Total directory sizes with max size " << max_size << ": "
+                  << selected_sizes << std::endl;
+      } break;
+      case Part::SECOND: {
+        // The size to free is only known once all files were seen, so a first pass only
+        // sums up the file sizes. Then a single running minimum is enough while streaming.
+        std::size_t total_used = readTotalSize(ifile);
+        std::cout << "Total size used is " << total_used << std::endl;
+
+        std::size_t current_free = TOTAL_DISK_SIZE - total_used;
+        if (current_free > REQUIRED_SIZE) {
+          std::cout << "Have enough space!" << std::endl;
+        } else {
+          std::size_t min_to_free = REQUIRED_SIZE - current_free;
+          std::size_t min_feasible_dir_size = total_used;
+          streamDirectorySizes(ifile, [&](std::size_t dir_size) {
+            if ((dir_size >= min_to_free) && (dir_size < min_feasible_dir_size)) {
+              min_feasible_dir_size = dir_size;
+            }
+          });
+
+          std::cout << "Size of smallest dir to free enough space: "
+                    << min_feasible_dir_size << std::endl;
+        }
+      } break;
+    }
+    return 0;
+  }
+
+  if (method == Method::FLAT) {
+    FlatTree tree;
+    std::uint32_t current_node = FlatTree::ROOT;
+
+    CliCommand cli;
+    while (parse(ifile, cli), cli.command != Command::INVALID) {
+      switch (cli.command) {
+        case Command::CD_ROOT:
+          current_node = FlatTree::ROOT;
+          break;
+        case Command::CD:
+          current_node = tree.visitChild(current_node, cli.name);
+          break;
+        case Command::LS:
+          tree.local_sizes[current_node] += readListing(ifile);
+          break;
+        case Command::INVALID:
+          break;
+      }
+    }
+
+    const std::vector<std::size_t> total_sizes = tree.getTotalSizes();
+    switch (part) {
+      case Part::FIRST: {
+        std::size_t max_size = 100000;
+        std::size_t selected_sizes = 0;
+        for (std::size_t dir_size : total_sizes) {
+          if (dir_size <= max_size) {
+            selected_sizes += dir_size;
+          }
+        }
+
+        std::cout << "Total directory sizes with max size " << max_size << ": "
+                  << selected_sizes << std::endl;
+      } break;
+      case Part::SECOND: {
+        std::size_t total_used = total_sizes[FlatTree::ROOT];
+        std::cout << "Total size used is " << total_used << std::endl;
+
+        std::size_t current_free = TOTAL_DISK_SIZE - total_used;
+        if (current_free > REQUIRED_SIZE) {
+          std::cout << "Have enough space!" << std::endl;
+        } else {
+          std::size_t min_to_free = REQUIRED_SIZE - current_free;
+          std::size_t min_feasible_dir_size = total_used;
+          for (std::size_t dir_size : total_sizes) {
+            if ((dir_size >= min_to_free) && (dir_size < min_feasible_dir_size)) {
+              min_feasible_dir_size = dir_size;
+            }
+          }
+
+          std::cout << "Size of smallest dir to free enough space: "
+                    << min_feasible_dir_size << std::endl;
+        }
+      } break;
+    }
+    return 0;
+  }
+
   Node root(nullptr, "root");
   Node* current_node = &root;
 
@@ -98,19 +291,10 @@ int main(int argc, char** argv) {
         current_node = current_node->visitChild(cli.name);
         break;
       case Command::LS:
-        // read current directory
-        std::string element;
-        int next_char = ifile.peek();
-        while (ifile.peek() != '$' && ifile.good()) {
-          ifile >> element;
-          if (element.front() != 'd') {  // directory, don't care
-            // can we have multiple ls of the same
-            // directory? if yes, we need to keep track of
-            // which file is how big... assuming not needed
-            current_node->local_size += std::stoi(element);
-          }
-          ifile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        }
+        // can we have multiple ls of the same
+        // directory? if yes, we need to keep track of
+        // which file is how big... assuming not needed
+        current_node->local_size += readListing(ifile);
         break;
     }
   }
@@ -126,11 +310,8 @@ int main(int argc, char** argv) {
                 << selected_sizes << std::endl;
     } break;
     case Part::SECOND: {
-      // TODO: would there be a single pass algorithm to optimize this?
-      // Maybe even one that avoids building the tree in the first place?
-      constexpr std::size_t TOTAL_DISK_SIZE = 70000000;
-      constexpr std::size_t REQUIRED_SIZE = 30000000;
-
+      // Note: method 1 avoids building the tree, part 2 takes two passes with memory
+      // depending only on the depth of the tree
       std::size_t total_used = root.getTotalSize();
       std::cout << "Total size used is " << total_used << std::endl;
 
@@ -208,6 +389,105 @@ std::size_t Node::getSmallestFeasibleSize(std::size_t min_size,
   return dir_size;
 }
 
+std::uint32_t NamePool::intern(std::string_view name) {
+  const std::size_t mask = slots_.size() - 1;
+  std::size_t slot = std::hash<std::string_view>{}(name) & mask;
+  while (slots_[slot] != 0) {
+    if (get(slots_[slot] - 1) == name) {
+      return slots_[slot] - 1;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  const auto id = static_cast<std::uint32_t>(size());
+  chars_.append(name);
+  offsets_.push_back(static_cast<std::uint32_t>(chars_.size()));
+  slots_[slot] = id + 1;
+
+  // keep the load factor at most one half
+  if (2 * size() > slots_.size()) {
+    grow();
+  }
+  return id;
+}
+
+std::string_view NamePool::get(std::uint32_t id) const {
+  return std::string_view(chars_).substr(offsets_[id], offsets_[id + 1] - offsets_[id]);
+}
+
+void NamePool::grow() {
+  slots_.assign(2 * slots_.size(), 0);
+  const std::size_t mask = slots_.size() - 1;
+  for (std::uint32_t id = 0; id < size(); ++id) {
+    std::size_t slot = std::hash<std::string_view>{}(get(id)) & mask;
+    while (slots_[slot] != 0) {
+      slot = (slot + 1) & mask;
+    }
+    slots_[slot] = id + 1;
+  }
+}
+
+FlatTree::FlatTree() {
+  parents.push_back(ROOT);
+  name_ids.push_back(names.intern("/"));
+  local_sizes.push_back(0);
+}
+
+std::uint32_t FlatTree::visitChild(std::uint32_t node, const std::string& name) {
+  if (name == "..") {
+    return parents[node];
+  }
+
+  const std::uint32_t name_id = names.intern(name);
+  const std::size_t slot = childSlot(node, name_id);
+  if (child_slots_[slot] != 0) {
+    return child_slots_[slot];
+  }
+
+  const auto child = static_cast<std::uint32_t>(parents.size());
+  parents.push_back(node);
+  name_ids.push_back(name_id);
+  local_sizes.push_back(0);
+  child_slots_[slot] = child;
+
+  // keep the load factor at most one half
+  if (2 * parents.size() > child_slots_.size()) {
+    growChildren();
+  }
+  return child;
+}
+
+std::size_t FlatTree::childSlot(std::uint32_t node, std::uint32_t name_id) const {
+  // multiplicative hash of the (parent, name id) pair
+  const std::uint64_t key = (static_cast<std::uint64_t>(node) << 32) | name_id;
+  const std::size_t mask = child_slots_.size() - 1;
+  std::size_t slot = static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+  while (child_slots_[slot] != 0) {
+    const std::uint32_t child = child_slots_[slot];
+    if (parents[child] == node && name_ids[child] == name_id) {
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+void FlatTree::growChildren() {
+  child_slots_.assign(2 * child_slots_.size(), 0);
+  for (std::uint32_t child = ROOT + 1; child < parents.size(); ++child) {
+    child_slots_[childSlot(parents[child], name_ids[child])] = child;
+  }
+}
+
+std::vector<std::size_t> FlatTree::getTotalSizes() const {
+  std::vector<std::size_t> total_sizes = local_sizes;
+  // children come after their parent, so each node is complete before it is added
+  for (std::size_t i = total_sizes.size() - 1; i > ROOT; --i) {
+    total_sizes[parents[i]] += total_sizes[i];
+  }
+  return total_sizes;
+}
+
 void parse(std::ifstream& ifile, CliCommand& cli) {
   cli.command = Command::INVALID;
   char c = static_cast<char>(ifile.peek());
@@ -236,6 +516,76 @@ void parse(std::ifstream& ifile, CliCommand& cli) {
   ifile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 }
 
+std::size_t readListing(std::ifstream& ifile) {
+  // read current directory
+  std::size_t local_size = 0;
+  std::string element;
+  while (ifile.peek() != '$' && ifile.good()) {
+    ifile >> element;
+    if (element.front() != 'd') {  // directory, don't care
+      local_size += std::stoul(element);
+    }
+    ifile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  }
+  return local_size;
+}
+
+std::size_t readTotalSize(std::ifstream& ifile) {
+  // only lines of files start with a digit
+  std::size_t total_size = 0;
+  std::string line;
+  while (std::getline(ifile, line)) {
+    if (!line.empty() && std::isdigit(static_cast<unsigned char>(line.front()))) {
+      total_size += std::stoul(line);
+    }
+  }
+
+  ifile.clear();
+  ifile.seekg(0);
+  return total_size;
+}
+
+template <typename EmitFn>
+std::size_t streamDirectorySizes(std::ifstream& ifile, EmitFn emit) {
+  std::vector<std::size_t> open_sizes = {0};  // root first
+
+  auto leave_directory = [&]() {
+    const std::size_t dir_size = open_sizes.back();
+    open_sizes.pop_back();
+    open_sizes.back() += dir_size;
+    emit(dir_size);
+  };
+
+  CliCommand cli;
+  while (parse(ifile, cli), cli.command != Command::INVALID) {
+    switch (cli.command) {
+      case Command::CD_ROOT:
+        while (open_sizes.size() > 1) {
+          leave_directory();
+        }
+        break;
+      case Command::CD:
+        if (cli.name != "..") {
+          open_sizes.push_back(0);
+        } else if (open_sizes.size() > 1) {
+          leave_directory();
+        }
+        break;
+      case Command::LS:
+        open_sizes.back() += readListing(ifile);
+        break;
+      case Command::INVALID:
+        break;
+    }
+  }
+
+  while (open_sizes.size() > 1) {
+    leave_directory();
+  }
+  emit(open_sizes.front());
+  return open_sizes.front();
+}
+
 void print(const Node& node) {
   std::cout << "root: " << node.children.size() << std::endl;
 